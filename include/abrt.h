@@ -26,6 +26,7 @@ extern "C" {
 
 #include "report_type.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <sys/types.h>
 
 bool
@@ -72,6 +73,33 @@ struct sr_report *
 sr_abrt_report_from_dir(const char *directory,
                         char **error_message);
 
+/**
+ * Creates reports from many ABRT problem directories concurrently.
+ * Each worker reads its directories through a single buffer and opens
+ * the files relative to the directory, so importing a large number of
+ * directories avoids most of the per-file overhead.
+ * @param directories
+ * Array of count problem directory paths.
+ * @param workers
+ * Number of worker threads.  Zero means one per online processor.
+ * @param reports
+ * Array of count elements.  The report created from directories[i] is
+ * stored to reports[i], or NULL if creating it failed.  The reports
+ * must be released by sr_report_free().
+ * @param error_messages
+ * Array of count elements or NULL.  If a report cannot be created, the
+ * error message is stored to error_messages[i] and must be released by
+ * free(); it is set to NULL for the created reports.
+ * @returns
+ * The number of reports created.
+ */
+size_t
+sr_abrt_reports_from_dirs(const char *const *directories,
+                          size_t count,
+                          unsigned workers,
+                          struct sr_report **reports,
+                          char **error_messages);
+
 /* Deprecated: use sr_report_type_from_type() instead */
 enum sr_report_type
 sr_abrt_type_from_analyzer(const char *analyzer);
@@ -32,6 +32,7 @@ extern "C" {
 #include "../report_type.h"
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 struct sr_core_thread;
 struct sr_location;
@@ -123,6 +124,15 @@ struct sr_core_stacktrace *
 sr_core_stacktrace_from_json_text(const char *text,
                                   char **error_message);
 
+/**
+ * Same as sr_core_stacktrace_from_json_text(), but reads at most length
+ * bytes of the text, which does not need to be NUL-terminated.
+ */
+struct sr_core_stacktrace *
+sr_core_stacktrace_from_json_text_n(const char *text,
+                                    size_t length,
+                                    char **error_message);
+
 /**
  * Returns brief, human-readable explanation of the stacktrace.
  */
@@ -24,22 +24,171 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 struct sr_core_stacktrace;
 struct sr_gdb_stacktrace;
 
+/**
+ * Unwinds the threads of the coredump of the executable.  With the
+ * elfutils unwinder, coredumps may be parsed by many threads at once; the
+ * build id and demangling caches are shared by them.
+ */
 struct sr_core_stacktrace *
 sr_parse_coredump(const char *coredump_filename,
                   const char *executable_filename,
                   char **error_message);
 
+/**
+ * @brief Options controlling how sr_parse_coredump_ex() unwinds threads.
+ *
+ * A structure filled with zeros gives the behaviour of
+ * sr_parse_coredump().  The options are supported only by the elfutils
+ * unwinder.  The libunwind one always unwinds all threads sequentially,
+ * and it fails if crash_thread_only or max_threads is set.
+ */
+struct sr_core_unwind_options
+{
+    /**
+     * Number of threads of the crashed process that are unwound
+     * concurrently.  Values 0 and 1 unwind them one by one.  Each worker
+     * opens the coredump on its own, so this is worth it only for
+     * processes with many threads.  The threads of the resulting
+     * stacktrace are in the same order regardless of this value.
+     */
+    unsigned workers;
+    /**
+     * Unwind only the thread that received the signal which terminated
+     * the process, as recorded in its NT_PRSTATUS note.  The first
+     * thread is unwound if no such thread is found.
+     */
+    bool crash_thread_only;
+    /**
+     * Unwind at most this many threads, 0 means no limit.  The crash
+     * thread is always among the unwound threads; the others are the
+     * first ones in the order of the coredump.
+     */
+    unsigned max_threads;
+};
+
+/**
+ * Same as sr_parse_coredump(), but the unwinding can be tuned by the
+ * options.  Passing NULL options is the same as calling
+ * sr_parse_coredump().
+ */
+struct sr_core_stacktrace *
+sr_parse_coredump_ex(const char *coredump_filename,
+                     const char *executable_filename,
+                     const struct sr_core_unwind_options *options,
+                     char **error_message);
+
 struct sr_core_stacktrace *
 sr_core_stacktrace_from_gdb(const char *gdb_output,
                             const char *coredump_filename,
                             const char *executable_filename,
                             char **error_message);
 
+/**
+ * @brief A module mapped in the address space of the crashed process.
+ */
+struct sr_core_segment
+{
+    /** First address of the module. */
+    uint64_t start;
+    /** Address just past the end of the module. */
+    uint64_t end;
+    /** File the module has been loaded from. */
+    char *file_name;
+    /** Build id of the module in hexadecimal, or NULL if unknown. */
+    char *build_id;
+};
+
+/**
+ * @brief Modules of a coredump sorted by their start addresses.
+ *
+ * The unwinder uses it to map addresses to modules, and it is useful for
+ * mapping the addresses of frames to files when post-processing them.
+ */
+struct sr_core_segment_index;
+
+/**
+ * Reads the modules mapped in the coredump.  Only the modules whose ELF
+ * files have been found are included.
+ * @returns
+ * NULL and an error message on failure.  The index must be released by
+ * calling the function sr_core_segment_index_free().
+ */
+struct sr_core_segment_index *
+sr_core_segment_index_from_coredump(const char *coredump_filename,
+                                    const char *executable_filename,
+                                    char **error_message);
+
+/**
+ * Releases the index and its segments.
+ * @param index
+ * If index is NULL, no operation is performed.
+ */
+void
+sr_core_segment_index_free(struct sr_core_segment_index *index);
+
+/**
+ * Returns the number of segments in the index.
+ */
+size_t
+sr_core_segment_index_count(const struct sr_core_segment_index *index);
+
+/**
+ * Returns the i-th segment in the order of the start addresses.
+ */
+const struct sr_core_segment *
+sr_core_segment_index_get(const struct sr_core_segment_index *index,
+                          size_t i);
+
+/**
+ * Finds the segment containing the address in logarithmic time.
+ * @returns
+ * NULL if no segment contains the address.
+ */
+const struct sr_core_segment *
+sr_core_segment_index_find(const struct sr_core_segment_index *index,
+                           uint64_t address);
+
+struct sr_build_id_cache_stats
+{
+    /** Lookups answered from the cache. */
+    unsigned long hits;
+    /** Lookups of data that was not cached yet. */
+    unsigned long misses;
+    /** Number of cached files and symbols. */
+    size_t size;
+    /** Maximum number of cached files and symbols. */
+    size_t capacity;
+};
+
+/**
+ * Sets the maximum number of ELF files and function names kept by the
+ * cache shared by the coredumps unwound in the process, evicting the
+ * least recently used ones if needed.  Zero disables the cache.
+ */
+void
+sr_build_id_cache_set_capacity(size_t capacity);
+
+/**
+ * Drops all the cached files and function names and resets the
+ * counters, e.g. after packages have been updated.
+ */
+void
+sr_build_id_cache_clear(void);
+
+/**
+ * Fills stats with the current state of the build id cache.
+ */
+void
+sr_build_id_cache_get_stats(struct sr_build_id_cache_stats *stats);
+
 /* This function can be used to unwind stack of live ("dying") process, invoked
  * from the core dump hook (/proc/sys/kernel/core_pattern).
  *
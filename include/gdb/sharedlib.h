@@ -117,6 +117,39 @@ struct sr_gdb_sharedlib *
 sr_gdb_sharedlib_find_address(struct sr_gdb_sharedlib *first,
                               uint64_t address);
 
+/**
+ * @brief Sorted array of the address ranges of a sharedlib list.
+ *
+ * The index refers to the sharedlibs of the list it has been built from,
+ * the list must outlive the index and must not be modified meanwhile.
+ */
+struct sr_gdb_sharedlib_index;
+
+/**
+ * Builds the index of the list starting by 'first'.
+ * @returns
+ * It never returns NULL. The returned pointer must be released by
+ * calling the function sr_gdb_sharedlib_index_free().
+ */
+struct sr_gdb_sharedlib_index *
+sr_gdb_sharedlib_index_new(struct sr_gdb_sharedlib *first);
+
+/**
+ * Releases the index.  The indexed sharedlibs are not released.
+ * @param index
+ * If index is NULL, no operation is performed.
+ */
+void
+sr_gdb_sharedlib_index_free(struct sr_gdb_sharedlib_index *index);
+
+/**
+ * Same as sr_gdb_sharedlib_find_address() on the indexed list, but
+ * takes logarithmic time in the number of sharedlibs.
+ */
+struct sr_gdb_sharedlib *
+sr_gdb_sharedlib_index_find_address(const struct sr_gdb_sharedlib_index *index,
+                                    uint64_t address);
+
 /**
  * Parses the output of GDB's 'info sharedlib' command.
  * @param input
@@ -37,6 +37,7 @@ struct sr_gdb_frame;
 struct sr_strbuf;
 struct sr_location;
 struct sr_gdb_sharedlib;
+struct sr_gdb_sharedlib_index;
 
 /**
  * @brief A thread of execution of a GDB-produced stack trace.
@@ -264,6 +265,15 @@ void
 sr_gdb_thread_set_libnames(struct sr_gdb_thread *thread,
                            struct sr_gdb_sharedlib *libs);
 
+/**
+ * Same as sr_gdb_thread_set_libnames(), but looks the frame addresses up
+ * in an index built by sr_gdb_sharedlib_index_new().  Useful when setting
+ * the library names of many threads at once.
+ */
+void
+sr_gdb_thread_set_libnames_indexed(struct sr_gdb_thread *thread,
+                                   const struct sr_gdb_sharedlib_index *index);
+
 /**
  * Return copy of the thread optimized for comparison.
  */
@@ -36,6 +36,8 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+
 struct sr_location;
 struct sr_strbuf;
 
@@ -110,6 +112,11 @@ struct sr_json_value
 struct sr_json_value *
 sr_json_parse(const char *json, char **error_message);
 
+/* Parses at most length bytes of json, which does not need to be
+ * NUL-terminated. */
+struct sr_json_value *
+sr_json_parse_n(const char *json, size_t length, char **error_message);
+
 struct sr_json_value *
 sr_json_parse_ex(struct sr_json_settings *settings,
                  const char *json,
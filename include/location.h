@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * @brief A location of a parser in the input stream.
@@ -154,6 +155,32 @@ sr_location_eat_char_ext(int *line,
                          int *column,
                          char c);
 
+/**
+ * Updates the line and column of the location by moving "after" the
+ * first length chars of s.  The result is the same as if
+ * sr_location_eat_char() was called for every char, but the text is
+ * scanned in bulk.  Parsers can therefore skip over a piece of input
+ * first and account for it in the location once.
+ */
+void
+sr_location_eat_chars(struct sr_location *location,
+                      const char *s,
+                      size_t length);
+
+/**
+ * Updates the line and the column by moving "after" the first length
+ * chars of s, as sr_location_eat_chars() does.
+ * @param line
+ * Must be a valid pointer.
+ * @param column
+ * Must be a valid pointer.
+ */
+void
+sr_location_eat_chars_ext(int *line,
+                          int *column,
+                          const char *s,
+                          size_t length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+
 struct sr_gdb_frame;
 struct sr_gdb_thread;
 struct sr_gdb_stacktrace;
@@ -47,6 +49,28 @@ sr_normalize_gdb_stacktrace(struct sr_gdb_stacktrace *stacktrace);
 void
 sr_normalize_core_thread(struct sr_core_thread *thread);
 
+/**
+ * Loads additional normalization rules from a file and adds them to the
+ * built-in ones.  Every line contains a single rule with tab-separated
+ * fields, empty lines and lines starting with '#' are ignored:
+ * @code
+ * remove<TAB>FUNCTION[<TAB>SOURCE_FILE...]
+ * remove-with-above<TAB>FUNCTION[<TAB>SOURCE_FILE...]
+ * rename<TAB>FUNCTION<TAB>NEW_FUNCTION[<TAB>SOURCE_FILE...]
+ * @endcode
+ * A rule applies to frames with exactly the function name whose source
+ * file contains one of the listed strings.  A rule without source files
+ * applies to every frame with a known source file.  A line may have at
+ * most 64 fields.
+ * @returns
+ * True on success.  On failure, false is returned and *error_message is
+ * set to a malloc()ed message; no rule of the file is added then.  The
+ * rules may be loaded while other threads normalize.
+ */
+bool
+sr_normalize_load_rules(const char *filename,
+                        char **error_message);
+
 // TODO: move to gdb_stacktrace.h
 /**
  * Checks whether the thread it contains some function used to exit
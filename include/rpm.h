@@ -31,6 +31,7 @@ extern "C" {
 
 #include <stdbool.h>
 #include <inttypes.h>
+#include <stddef.h>
 
 struct sr_json_value;
 
@@ -161,6 +162,17 @@ sr_rpm_package_sort(struct sr_rpm_package *packages);
 struct sr_rpm_package *
 sr_rpm_package_uniq(struct sr_rpm_package *packages);
 
+/**
+ * Sorts the packages by their NEVRA and merges the duplicates, with the
+ * same result as sr_rpm_package_uniq(sr_rpm_package_sort(packages)).
+ * The duplicates are found by hashing, so only the distinct packages
+ * are sorted.
+ * @returns
+ * The sorted list, NULL if packages is NULL.
+ */
+struct sr_rpm_package *
+sr_rpm_package_sort_uniq(struct sr_rpm_package *packages);
+
 struct sr_rpm_package *
 sr_rpm_package_get_by_name(const char *name,
                            char **error_message);
@@ -169,6 +181,84 @@ struct sr_rpm_package *
 sr_rpm_package_get_by_path(const char *path,
                            char **error_message);
 
+/**
+ * @brief A package database with a cache of file owners.
+ *
+ * Opening the RPM database is expensive, so the database keeps its
+ * transaction set and remembers which packages own the files looked up
+ * so far.  The database may be shared by threads, lookups are
+ * serialized.
+ */
+struct sr_rpm_db;
+
+/**
+ * Looks up the packages owning the file for a database created by
+ * sr_rpm_db_new_from_lookup().  Returns the list of packages, or NULL
+ * if no package owns the file.  On failure, NULL is returned and
+ * *error_message is set.
+ */
+typedef struct sr_rpm_package *
+(*sr_rpm_db_lookup_fn)(const char *path,
+                       void *data,
+                       char **error_message);
+
+/**
+ * Opens the system RPM database.
+ * @returns
+ * The database, which must be released by sr_rpm_db_free(), or NULL
+ * with *error_message set if satyr was compiled without rpm or the RPM
+ * configuration cannot be read.  The lookups of a database are
+ * serialized, so it can be shared by many threads.
+ */
+struct sr_rpm_db *
+sr_rpm_db_open(char **error_message);
+
+/**
+ * Creates a database answering the lookups by calling the function
+ * with the data.  The results are cached the same way as for the
+ * system database, which makes it usable as a stand-in for it.
+ */
+struct sr_rpm_db *
+sr_rpm_db_new_from_lookup(sr_rpm_db_lookup_fn lookup,
+                          void *data);
+
+/**
+ * Releases the database and its cache.
+ */
+void
+sr_rpm_db_free(struct sr_rpm_db *db);
+
+/**
+ * Returns the packages owning the file, NULL if there are none.  Every
+ * path is looked up in the database only once.
+ * @returns
+ * The list of packages, which must be released by
+ * sr_rpm_package_free().  On failure, NULL is returned and
+ * *error_message is set.
+ */
+struct sr_rpm_package *
+sr_rpm_db_get_by_path(struct sr_rpm_db *db,
+                      const char *path,
+                      char **error_message);
+
+/**
+ * Looks up the owners of many files at once, e.g. of all the shared
+ * libraries of a crashed process.  The lookups share the open database
+ * and the cache, so the same path is only looked up once.
+ * @param packages
+ * Array of count elements.  The list of packages owning paths[i] is
+ * stored to packages[i], NULL if there is none.
+ * @returns
+ * True on success.  On failure, no packages are returned and
+ * *error_message is set.
+ */
+bool
+sr_rpm_packages_get_by_paths(struct sr_rpm_db *db,
+                             const char *const *paths,
+                             size_t count,
+                             struct sr_rpm_package **packages,
+                             char **error_message);
+
 char *
 sr_rpm_package_to_json(struct sr_rpm_package *package,
                        bool recursive);
@@ -191,6 +281,19 @@ sr_rpm_package_parse_nevra(const char *text,
                            char **release,
                            char **architecture);
 
+/**
+ * Same as sr_rpm_package_parse_nevra(), but parses the first length
+ * bytes of the text, which does not need to be NUL-terminated.
+ */
+bool
+sr_rpm_package_parse_nevra_n(const char *text,
+                             size_t length,
+                             char **name,
+                             uint32_t *epoch,
+                             char **version,
+                             char **release,
+                             char **architecture);
+
 struct sr_rpm_consistency *
 sr_rpm_consistency_new(void);
 
@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 #include "report_type.h"
+#include <stddef.h>
 
 struct sr_json_value;
 
@@ -64,6 +65,18 @@ enum sr_bthash_flags
 struct sr_stacktrace *
 sr_stacktrace_parse(enum sr_report_type type, const char *input, char **error_message);
 
+/**
+ * Same as sr_stacktrace_parse(), but reads at most length bytes of the
+ * input, which does not need to be NUL-terminated.  Only core
+ * stacktraces, which are JSON, are parsed in place.  The text parsers of
+ * the other types rely on the terminating NUL byte, so they are given a
+ * terminated copy of the input unless it contains a NUL byte within the
+ * first length bytes.
+ */
+struct sr_stacktrace *
+sr_stacktrace_parse_n(enum sr_report_type type, const char *input,
+                      size_t length, char **error_message);
+
 /**
  * Returns short textual representation of given stacktrace. At most max_frames
  * are printed. Caller needs to free the result using free() afterwards.
@@ -48,7 +48,8 @@ extern "C" {
 
 /**
  * Debugging output to stdout while parsing.
- * Default value is false.
+ * Default value is false.  It is not locked, so it has to be set before
+ * any thread calls the parsers.
  */
 extern bool
 sr_debug_parser;
@@ -181,6 +182,46 @@ sr_string_to_file(const char *filename,
                   char *contents,
                   char **error_message);
 
+/**
+ * @brief A read-only view of file contents.
+ *
+ * Regular files are mapped into memory instead of being copied, and
+ * there is no limit on their size.  The contents are always followed
+ * by a NUL byte, so they can be passed directly to the parsers.
+ */
+struct sr_mapped_file
+{
+    /** File contents terminated by a NUL byte.  Do not modify. */
+    const char *contents;
+    /** Size of the contents, not counting the terminating NUL. */
+    size_t size;
+
+    /* Private members. */
+    void *mapping;
+    size_t mapping_size;
+};
+
+/**
+ * Maps file contents to memory.  Files which cannot be mapped (pipes,
+ * character devices) are read into a buffer instead.
+ * @returns
+ * The mapped file, which must be released by sr_mapped_file_close().
+ * If file opening/mapping fails, NULL is returned and error_message
+ * is set.
+ */
+struct sr_mapped_file *
+sr_mapped_file_open(const char *filename,
+                    char **error_message);
+
+/**
+ * Unmaps the file and releases the structure.  Pointers to the
+ * contents become invalid.
+ * @param file
+ * If file is NULL, no operation is performed.
+ */
+void
+sr_mapped_file_close(struct sr_mapped_file *file);
+
 /**
  * If the input contains character c in the current positon, move the
  * input pointer after the character, and return true. Otherwise do
@@ -381,6 +422,14 @@ sr_skip_non_whitespace(const char *s);
 bool
 sr_skip_to_next_line_location(const char **s, int *line, int *column);
 
+/*
+ * Length-bounded variant of sr_parse_uint64().  It never reads the byte
+ * at end or anything behind it, so the input can be a slice of a larger
+ * buffer that is not NUL-terminated.
+ */
+int
+sr_parse_uint64_n(const char **input, const char *end, uint64_t *result);
+
 /**
  * Emit a string of hex representation of bytes.
  */
@@ -407,13 +456,59 @@ sr_parse_os_release(const char *input,
                     void *data);
 
 /**
- * Demangles C++ symbol.
+ * Demangles C++ symbol.  The results are kept in a bounded LRU cache
+ * shared by all threads, see sr_demangle_cache_set_capacity().
  * @returns
  * The demangled symbol (allocated by malloc), or NULL on failure.
  */
 char *
 sr_demangle_symbol(const char *sym);
 
+/**
+ * Demangles count symbols at once, taking the cache lock once for the
+ * lookups and once for storing the new results.  The symbols missing from
+ * the cache are demangled without holding the lock.
+ * Stores the result of sr_demangle_symbol() for symbols[i] to results[i],
+ * the caller releases the non-NULL results by free().  NULL symbols
+ * produce NULL results.
+ */
+void
+sr_demangle_symbols(const char *const *symbols,
+                    size_t count,
+                    char **results);
+
+struct sr_demangle_cache_stats
+{
+    /* Lookups answered from the cache. */
+    unsigned long hits;
+    /* Lookups that had to call the demangler. */
+    unsigned long misses;
+    /* Number of cached symbols. */
+    size_t size;
+    /* Maximum number of cached symbols. */
+    size_t capacity;
+};
+
+/**
+ * Sets the maximum number of symbols kept by the demangling cache,
+ * evicting the least recently used ones if needed.  Zero disables
+ * the cache.
+ */
+void
+sr_demangle_cache_set_capacity(size_t capacity);
+
+/**
+ * Drops all the cached symbols and resets the counters.
+ */
+void
+sr_demangle_cache_clear(void);
+
+/**
+ * Fills stats with the current state of the demangling cache.
+ */
+void
+sr_demangle_cache_get_stats(struct sr_demangle_cache_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
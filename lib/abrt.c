@@ -39,15 +39,174 @@
 #include <string.h>
 #include <limits.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* An ABRT problem directory being read.  The files are opened relative
+ * to the directory descriptor, so no paths are built, and are read into
+ * a buffer that is reused for all the files and directories read through
+ * the structure. */
+struct problem_dir
+{
+    const char *path;
+    int fd;
+    char *buffer;
+    size_t allocated;
+};
+
+static void
+problem_dir_init(struct problem_dir *dir)
+{
+    dir->path = NULL;
+    dir->fd = -1;
+    dir->buffer = NULL;
+    dir->allocated = 0;
+}
+
+/* Closes the directory, but keeps the buffer for the next one. */
+static void
+problem_dir_close(struct problem_dir *dir)
+{
+    if (dir->fd >= 0)
+        close(dir->fd);
+
+    dir->path = NULL;
+    dir->fd = -1;
+}
+
+static void
+problem_dir_destroy(struct problem_dir *dir)
+{
+    problem_dir_close(dir);
+    free(dir->buffer);
+    dir->buffer = NULL;
+    dir->allocated = 0;
+}
+
+static bool
+problem_dir_open(struct problem_dir *dir,
+                 const char *path,
+                 char **error_message)
+{
+    problem_dir_close(dir);
+
+    dir->fd = open(path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (dir->fd < 0)
+    {
+        *error_message = sr_asprintf("Unable to open '%s': %s.",
+                                     path, strerror(errno));
+        return false;
+    }
+
+    dir->path = path;
+    return true;
+}
+
+/* Gives the error of sr_file_to_string() for files over the limit. */
+static const char *
+file_too_big(uintmax_t size, char **error_message)
+{
+    *error_message = sr_asprintf("Input file too big (%lld). Maximum size is %zu.",
+                                 (long long)size,
+                                 FILE_SIZE_LIMIT);
+    return NULL;
+}
+
+/* Reads the file into the buffer of the directory and returns it.  The
+ * contents are terminated by a NUL byte and stay valid until the next
+ * read. */
+static const char *
+file_read(struct problem_dir *dir, const char *file, size_t *size,
+          char **error_message)
+{
+    const char *action = "open";
+    int fd = openat(dir->fd, file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        goto fail;
+
+    /* The size is only a hint, files in /proc report zero.  Files over the
+     * limit of sr_file_to_string() are refused like there. */
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        if ((uintmax_t)st.st_size > FILE_SIZE_LIMIT)
+        {
+            close(fd);
+            return file_too_big(st.st_size, error_message);
+        }
+
+        if ((size_t)st.st_size + 1 > dir->allocated)
+        {
+            dir->allocated = st.st_size + 1;
+            dir->buffer = sr_realloc(dir->buffer, dir->allocated);
+        }
+    }
+
+    /* The buffer holds at most one byte over the limit, which is enough
+     * to tell that a file growing meanwhile is too big. */
+    action = "read from";
+    size_t used = 0;
+    while (true)
+    {
+        if (used + 1 >= dir->allocated)
+        {
+            dir->allocated = (dir->allocated ? 2 * dir->allocated : 4096);
+            if (dir->allocated > FILE_SIZE_LIMIT + 2)
+                dir->allocated = FILE_SIZE_LIMIT + 2;
+
+            dir->buffer = sr_realloc(dir->buffer, dir->allocated);
+        }
+
+        ssize_t count = read(fd, dir->buffer + used, dir->allocated - used - 1);
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count < 0)
+            goto fail;
+
+        if (count == 0)
+            break;
+
+        used += count;
+        if (used > FILE_SIZE_LIMIT)
+        {
+            close(fd);
+            return file_too_big(used, error_message);
+        }
+    }
+
+    close(fd);
+    dir->buffer[used] = '\0';
+    if (size)
+        *size = used;
+
+    return dir->buffer;
+
+fail:
+    {
+        int saved_errno = errno;
+        if (fd >= 0)
+            close(fd);
+
+        char *path = sr_build_path(dir->path, file, NULL);
+        *error_message = sr_asprintf("Unable to %s '%s': %s.", action, path,
+                                     strerror(saved_errno));
+        free(path);
+        return NULL;
+    }
+}
 
 static char*
-file_contents(const char *directory, const char *file, char **error_message)
+file_contents(struct problem_dir *dir, const char *file, char **error_message)
 {
-    char *path = sr_build_path(directory, file, NULL);
-    char *contents = sr_file_to_string(path, error_message);
+    size_t size;
+    const char *contents = file_read(dir, file, &size, error_message);
+    if (!contents)
+        return NULL;
 
-    free(path);
-    return contents;
+    return sr_strndup(contents, size);
 }
 
 bool
@@ -91,10 +250,15 @@ static bool
 create_core_stacktrace(const char *directory, const char *gdb_output,
                        bool hash_fingerprints, char **error_message)
 {
-    char *executable_contents = file_contents(directory, "executable",
-                                              error_message);
+    struct problem_dir dir;
+    problem_dir_init(&dir);
+    char *executable_contents = NULL;
+    if (problem_dir_open(&dir, directory, error_message))
+        executable_contents = file_contents(&dir, "executable", error_message);
+
+    problem_dir_destroy(&dir);
     if (!executable_contents)
-        return NULL;
+        return false;
 
     char *coredump_filename = sr_build_path(directory, "coredump", NULL);
 
@@ -218,82 +382,61 @@ sr_abrt_create_core_stacktrace_from_core_hook(const char *directory,
 struct sr_rpm_package *
 sr_abrt_parse_dso_list(const char *text)
 {
-    struct sr_rpm_package *packages = NULL;
-    const char *pos = text;
-    while (pos && *pos)
+    /* Every line is "LIBRARY NEVRA (VENDOR) INSTALL_TIME".  The lines are
+     * parsed in place; only the fields of the packages are copied. */
+    struct sr_rpm_package *packages = NULL, **tail = &packages;
+    const char *line = text;
+    while (*line)
     {
-        // Skip dynamic library name.
-        pos = strchr(pos, ' ');
+        // A line without a newline is incomplete.
+        const char *eol = strchr(line, '\n');
+        if (!eol)
+            break;
 
-        if (!pos)
+        const char *pos = line;
+        line = eol + 1;
+
+        // Skip dynamic library name.
+        const char *nevra = memchr(pos, ' ', eol - pos);
+        if (!nevra)
             continue;
 
         // Skip the space.
-        ++pos;
+        ++nevra;
 
         // Find the package NEVRA.
-        char *end = strchr(pos, ' ');
-        if (!end || end - pos <= 1)
-        {
-            pos = strchr(pos, '\n');
+        const char *end = memchr(nevra, ' ', eol - nevra);
+        if (!end || end - nevra <= 1)
+            continue;
+
+        // Parse the package install time after the last space.
+        const char *install_time = (const char *)memrchr(end, ' ', eol - end) + 1;
+        uint64_t time;
+        int len = sr_parse_uint64_n(&install_time, eol, &time);
+        if (len <= 0)
             continue;
-        }
 
         // Parse the package NEVRA.
-        char *nevra = sr_strndup(pos, end - pos);
         struct sr_rpm_package *dso_package = sr_rpm_package_new();
-        bool success = sr_rpm_package_parse_nevra(nevra,
-                                                  &dso_package->name,
-                                                  &dso_package->epoch,
-                                                  &dso_package->version,
-                                                  &dso_package->release,
-                                                  &dso_package->architecture);
-
-        free(nevra);
+        bool success = sr_rpm_package_parse_nevra_n(nevra, end - nevra,
+                                                    &dso_package->name,
+                                                    &dso_package->epoch,
+                                                    &dso_package->version,
+                                                    &dso_package->release,
+                                                    &dso_package->architecture);
 
         // If parsing failed, move to the next line.
         if (!success)
         {
             sr_rpm_package_free(dso_package, true);
-            pos = strchr(pos, '\n');
             continue;
         }
 
-        // Find the package install time.
-        char *eol = strchr(pos, '\n');
-        if (!eol)
-        {
-            sr_rpm_package_free(dso_package, true);
-            break;
-        }
-
-        char *line = sr_strndup(pos, eol - pos);
-        pos = strrchr(line, ' ');
-        if (!pos)
-        {
-            pos = eol;
-            sr_rpm_package_free(dso_package, true);
-            free(line);
-            continue;
-        }
-
-        ++pos;
-
-        // Parse the package install time.
-        int len = sr_parse_uint64((const char**)&pos,
-                                  &dso_package->install_time);
-        free(line);
-
-        if (len <= 0)
-        {
-            pos = eol;
-            sr_rpm_package_free(dso_package, true);
-            continue;
-        }
+        dso_package->install_time = time;
 
         // Append the package to the list.
-        packages = sr_rpm_package_append(packages, dso_package);
-        pos = eol;
+        *tail = dso_package;
+        tail = &dso_package->next;
     }
 
     return packages;
@@ -307,12 +450,11 @@ strip_newline(char *str)
         *n = '\0';
 }
 
-struct sr_rpm_package *
-sr_abrt_rpm_packages_from_dir(const char *directory,
-                              char **error_message)
+static struct sr_rpm_package *
+rpm_packages_from_dir(struct problem_dir *dir,
+                      char **error_message)
 {
-
-    char *epoch_str = file_contents(directory, "pkg_epoch", error_message);
+    char *epoch_str = file_contents(dir, "pkg_epoch", error_message);
     if (!epoch_str)
     {
         return NULL;
@@ -328,10 +470,10 @@ sr_abrt_rpm_packages_from_dir(const char *directory,
     struct sr_rpm_package *packages = sr_rpm_package_new();
 
     packages->epoch = (uint32_t)epoch;
-    packages->name = file_contents(directory, "pkg_name", error_message);
-    packages->version = file_contents(directory, "pkg_version", error_message);
-    packages->release = file_contents(directory, "pkg_release", error_message);
-    packages->architecture = file_contents(directory, "pkg_arch", error_message);
+    packages->name = file_contents(dir, "pkg_name", error_message);
+    packages->version = file_contents(dir, "pkg_version", error_message);
+    packages->release = file_contents(dir, "pkg_release", error_message);
+    packages->architecture = file_contents(dir, "pkg_arch", error_message);
     packages->role = SR_ROLE_AFFECTED;
 
     if (!(packages->name && packages->version && packages->release &&
@@ -348,31 +490,40 @@ sr_abrt_rpm_packages_from_dir(const char *directory,
     strip_newline(packages->release);
     strip_newline(packages->architecture);
 
-    char *dso_list_contents = file_contents(directory, "dso_list",
-                                            error_message);
-    if (dso_list_contents)
+    const char *dso_list = file_read(dir, "dso_list", NULL, error_message);
+    if (dso_list)
     {
-        struct sr_rpm_package *dso_packages =
-            sr_abrt_parse_dso_list(dso_list_contents);
+        struct sr_rpm_package *dso_packages = sr_abrt_parse_dso_list(dso_list);
 
         if (dso_packages)
         {
-            packages = sr_rpm_package_append(packages, dso_packages);
-            packages = sr_rpm_package_sort(packages);
-            packages = sr_rpm_package_uniq(packages);
+            packages->next = dso_packages;
+            packages = sr_rpm_package_sort_uniq(packages);
         }
-
-        free(dso_list_contents);
     }
 
     return packages;
 }
 
+struct sr_rpm_package *
+sr_abrt_rpm_packages_from_dir(const char *directory,
+                              char **error_message)
+{
+    struct problem_dir dir;
+    problem_dir_init(&dir);
+    struct sr_rpm_package *packages = NULL;
+    if (problem_dir_open(&dir, directory, error_message))
+        packages = rpm_packages_from_dir(&dir, error_message);
+
+    problem_dir_destroy(&dir);
+    return packages;
+}
+
 static char *
-desktop_from_dir(const char *directory,
-                    char **error_message)
+desktop_from_dir(struct problem_dir *dir,
+                 char **error_message)
 {
-    char *environ_contents = file_contents(directory, "environ", error_message);
+    char *environ_contents = file_contents(dir, "environ", error_message);
     if (!environ_contents)
         return NULL;
 
@@ -402,11 +553,11 @@ desktop_from_dir(const char *directory,
 }
 
 static bool
-occurrences_from_dir(const char *directory,
+occurrences_from_dir(struct problem_dir *dir,
                      uint32_t *retval,
                      char **error_message)
 {
-    char *count_contents = file_contents(directory, "count", error_message);
+    char *count_contents = file_contents(dir, "count", error_message);
     if (!count_contents)
         return NULL;
 
@@ -448,14 +599,14 @@ finito:
     return result;
 }
 
-struct sr_operating_system *
-sr_abrt_operating_system_from_dir(const char *directory,
-                                  char **error_message)
+static struct sr_operating_system *
+operating_system_from_dir(struct problem_dir *dir,
+                          char **error_message)
 {
     bool success = false;
     struct sr_operating_system *os = sr_operating_system_new();
 
-    char *osinfo_contents = file_contents(directory, "os_info", error_message);
+    char *osinfo_contents = file_contents(dir, "os_info", error_message);
     if (osinfo_contents)
     {
         success = sr_operating_system_parse_etc_os_release(osinfo_contents, os);
@@ -465,7 +616,7 @@ sr_abrt_operating_system_from_dir(const char *directory,
     /* fall back to os_release if parsing os_info fails */
     if (!success)
     {
-        char *release_contents = file_contents(directory, "os_release",
+        char *release_contents = file_contents(dir, "os_release",
                                                error_message);
         if (release_contents)
         {
@@ -483,7 +634,7 @@ sr_abrt_operating_system_from_dir(const char *directory,
         return NULL;
     }
 
-    os->architecture = file_contents(directory, "architecture", error_message);
+    os->architecture = file_contents(dir, "architecture", error_message);
     if (!os->architecture)
     {
         sr_operating_system_free(os);
@@ -491,19 +642,33 @@ sr_abrt_operating_system_from_dir(const char *directory,
     }
 
     /* optional - failure is not fatal */
-    os->desktop = desktop_from_dir(directory, error_message);
+    os->desktop = desktop_from_dir(dir, error_message);
 
     return os;
 }
 
-struct sr_report *
-sr_abrt_report_from_dir(const char *directory,
-                        char **error_message)
+struct sr_operating_system *
+sr_abrt_operating_system_from_dir(const char *directory,
+                                  char **error_message)
+{
+    struct problem_dir dir;
+    problem_dir_init(&dir);
+    struct sr_operating_system *os = NULL;
+    if (problem_dir_open(&dir, directory, error_message))
+        os = operating_system_from_dir(&dir, error_message);
+
+    problem_dir_destroy(&dir);
+    return os;
+}
+
+static struct sr_report *
+report_from_dir(struct problem_dir *dir,
+                char **error_message)
 {
     struct sr_report *report = sr_report_new();
 
     /* Report type. */
-    char *type_contents = file_contents(directory, "type", error_message);
+    char *type_contents = file_contents(dir, "type", error_message);
     if (!type_contents)
     {
         sr_report_free(report);
@@ -514,8 +679,7 @@ sr_abrt_report_from_dir(const char *directory,
     free(type_contents);
 
     /* Operating system. */
-    report->operating_system = sr_abrt_operating_system_from_dir(
-        directory, error_message);
+    report->operating_system = operating_system_from_dir(dir, error_message);
 
     if (!report->operating_system)
     {
@@ -524,11 +688,10 @@ sr_abrt_report_from_dir(const char *directory,
     }
 
     /* Component name. */
-    report->component_name = file_contents(directory, "component", error_message);
+    report->component_name = file_contents(dir, "component", error_message);
 
     /* RPM packages. */
-    report->rpm_packages = sr_abrt_rpm_packages_from_dir(
-        directory, error_message);
+    report->rpm_packages = rpm_packages_from_dir(dir, error_message);
 
     if (!report->rpm_packages)
     {
@@ -537,7 +700,7 @@ sr_abrt_report_from_dir(const char *directory,
     }
 
     /* Serial. */
-    if (!occurrences_from_dir(directory, &report->serial, error_message))
+    if (!occurrences_from_dir(dir, &report->serial, error_message))
     {
         sr_report_free(report);
         return NULL;
@@ -546,18 +709,17 @@ sr_abrt_report_from_dir(const char *directory,
     /* Core stacktrace. */
     if (report->report_type == SR_REPORT_CORE)
     {
-        char *core_backtrace_contents = file_contents(directory, "core_backtrace",
-                                                      error_message);
-        if (!core_backtrace_contents)
+        const char *core_backtrace = file_read(dir, "core_backtrace", NULL,
+                                               error_message);
+        if (!core_backtrace)
         {
             sr_report_free(report);
             return NULL;
         }
 
         report->stacktrace = (struct sr_stacktrace *)sr_core_stacktrace_from_json_text(
-                core_backtrace_contents, error_message);
+                core_backtrace, error_message);
 
-        free(core_backtrace_contents);
         if (!report->stacktrace)
         {
             sr_report_free(report);
@@ -568,9 +730,9 @@ sr_abrt_report_from_dir(const char *directory,
     /* Python stacktrace. */
     if (report->report_type == SR_REPORT_PYTHON)
     {
-        char *backtrace_contents = file_contents(directory, "backtrace",
-                                                 error_message);
-        if (!backtrace_contents)
+        const char *backtrace = file_read(dir, "backtrace", NULL,
+                                          error_message);
+        if (!backtrace)
         {
             sr_report_free(report);
             return NULL;
@@ -579,12 +741,11 @@ sr_abrt_report_from_dir(const char *directory,
         /* Parse the Python stacktrace. */
         struct sr_location location;
         sr_location_init(&location);
-        const char *contents_pointer = backtrace_contents;
+        const char *contents_pointer = backtrace;
         report->stacktrace = (struct sr_stacktrace *)sr_python_stacktrace_parse(
             &contents_pointer,
             &location);
 
-        free(backtrace_contents);
         if (!report->stacktrace)
         {
             *error_message = sr_location_to_string(&location);
@@ -597,7 +758,7 @@ sr_abrt_report_from_dir(const char *directory,
     if (report->report_type == SR_REPORT_KERNELOOPS)
     {
         /* Determine kernel version */
-        char *kernel_contents = file_contents(directory, "kernel",
+        char *kernel_contents = file_contents(dir, "kernel",
                                               error_message);
         if (!kernel_contents)
         {
@@ -606,8 +767,9 @@ sr_abrt_report_from_dir(const char *directory,
         }
 
         /* Load the Kerneloops stacktrace */
-        char *backtrace_contents = file_contents(directory, "backtrace", error_message);
-        if (!backtrace_contents)
+        const char *backtrace = file_read(dir, "backtrace", NULL,
+                                          error_message);
+        if (!backtrace)
         {
             sr_report_free(report);
             return NULL;
@@ -616,7 +778,7 @@ sr_abrt_report_from_dir(const char *directory,
         /* Parse the Kerneloops stacktrace. */
         struct sr_location location;
         sr_location_init(&location);
-        const char *contents_pointer = backtrace_contents;
+        const char *contents_pointer = backtrace;
         struct sr_koops_stacktrace *stacktrace = sr_koops_stacktrace_parse(
             &contents_pointer,
             &location);
@@ -624,7 +786,6 @@ sr_abrt_report_from_dir(const char *directory,
         stacktrace->version = kernel_contents;
         report->stacktrace = (struct sr_stacktrace *)stacktrace;
 
-        free(backtrace_contents);
         if (!report->stacktrace)
         {
             *error_message = sr_location_to_string(&location);
@@ -636,8 +797,9 @@ sr_abrt_report_from_dir(const char *directory,
     /* Java stacktrace. */
     if (report->report_type == SR_REPORT_JAVA)
     {
-        char *backtrace_contents = file_contents(directory, "backtrace", error_message);
-        if (!backtrace_contents)
+        const char *backtrace = file_read(dir, "backtrace", NULL,
+                                          error_message);
+        if (!backtrace)
         {
             sr_report_free(report);
             return NULL;
@@ -646,12 +808,11 @@ sr_abrt_report_from_dir(const char *directory,
         /* Parse the Java stacktrace. */
         struct sr_location location;
         sr_location_init(&location);
-        const char *contents_pointer = backtrace_contents;
+        const char *contents_pointer = backtrace;
         report->stacktrace = (struct sr_stacktrace *)sr_java_stacktrace_parse(
             &contents_pointer,
             &location);
 
-        free(backtrace_contents);
         if (!report->stacktrace)
         {
             *error_message = sr_location_to_string(&location);
@@ -663,9 +824,9 @@ sr_abrt_report_from_dir(const char *directory,
     /* Ruby stacktrace. */
     if (report->report_type == SR_REPORT_RUBY)
     {
-        char *backtrace_contents = file_contents(directory, "backtrace",
-                                                 error_message);
-        if (!backtrace_contents)
+        const char *backtrace = file_read(dir, "backtrace", NULL,
+                                          error_message);
+        if (!backtrace)
         {
             sr_report_free(report);
             return NULL;
@@ -674,12 +835,11 @@ sr_abrt_report_from_dir(const char *directory,
         /* Parse the Ruby stacktrace. */
         struct sr_location location;
         sr_location_init(&location);
-        const char *contents_pointer = backtrace_contents;
+        const char *contents_pointer = backtrace;
         report->stacktrace = (struct sr_stacktrace *)sr_ruby_stacktrace_parse(
             &contents_pointer,
             &location);
 
-        free(backtrace_contents);
         if (!report->stacktrace)
         {
             *error_message = sr_location_to_string(&location);
@@ -691,6 +851,129 @@ sr_abrt_report_from_dir(const char *directory,
     return report;
 }
 
+struct sr_report *
+sr_abrt_report_from_dir(const char *directory,
+                        char **error_message)
+{
+    struct problem_dir dir;
+    problem_dir_init(&dir);
+    struct sr_report *report = NULL;
+    if (problem_dir_open(&dir, directory, error_message))
+        report = report_from_dir(&dir, error_message);
+
+    problem_dir_destroy(&dir);
+    return report;
+}
+
+struct reports_batch
+{
+    const char *const *directories;
+    size_t count;
+    struct sr_report **reports;
+    char **error_messages;
+    pthread_mutex_t lock;
+    size_t next;
+    size_t loaded;
+};
+
+static void *
+reports_batch_worker(void *arg)
+{
+    struct reports_batch *batch = arg;
+    struct problem_dir dir;
+    problem_dir_init(&dir);
+    size_t loaded = 0;
+
+    while (true)
+    {
+        pthread_mutex_lock(&batch->lock);
+        size_t i = batch->next++;
+        pthread_mutex_unlock(&batch->lock);
+
+        if (i >= batch->count)
+            break;
+
+        char *error_message = NULL;
+        struct sr_report *report = NULL;
+        if (problem_dir_open(&dir, batch->directories[i], &error_message))
+        {
+            report = report_from_dir(&dir, &error_message);
+            problem_dir_close(&dir);
+        }
+
+        /* Optional fields leave their error messages behind. */
+        if (report)
+        {
+            free(error_message);
+            error_message = NULL;
+            ++loaded;
+        }
+        else if (!error_message)
+            error_message = sr_strdup("Unable to create the report");
+
+        batch->reports[i] = report;
+        if (batch->error_messages)
+            batch->error_messages[i] = error_message;
+        else
+            free(error_message);
+    }
+
+    problem_dir_destroy(&dir);
+
+    pthread_mutex_lock(&batch->lock);
+    batch->loaded += loaded;
+    pthread_mutex_unlock(&batch->lock);
+    return NULL;
+}
+
+size_t
+sr_abrt_reports_from_dirs(const char *const *directories,
+                          size_t count,
+                          unsigned workers,
+                          struct sr_report **reports,
+                          char **error_messages)
+{
+    struct reports_batch batch = {
+        .directories = directories,
+        .count = count,
+        .reports = reports,
+        .error_messages = error_messages,
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .next = 0,
+        .loaded = 0,
+    };
+
+    if (workers == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (cpus > 0 ? cpus : 1);
+    }
+
+    if (workers > count)
+        workers = count;
+
+    pthread_t *threads = sr_malloc_array(workers, sizeof(*threads));
+    unsigned started;
+    for (started = 0; started < workers; ++started)
+    {
+        if (0 != pthread_create(&threads[started], NULL, reports_batch_worker,
+                                &batch))
+        {
+            break;
+        }
+    }
+
+    /* Without threads, the directories are read by the caller. */
+    if (started == 0)
+        reports_batch_worker(&batch);
+
+    for (unsigned i = 0; i < started; ++i)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+    return batch.loaded;
+}
+
 enum sr_report_type
 sr_abrt_type_from_type(const char *type)
 {
@@ -0,0 +1,373 @@
+/*
+    build_id_cache.c
+
+    Copyright (C) 2013  Red Hat, Inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "build_id_cache.h"
+#include "core/unwind.h"
+#include "hash_table.h"
+#include "utils.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* Default number of files and symbols kept by the cache. */
+#define BUILD_ID_CACHE_CAPACITY 65536
+
+/* Identifies the version of a file, so that a cached path to a file that
+ * has been removed or replaced since is not used. */
+struct file_stamp
+{
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec mtime;
+};
+
+/* The ELF file of a build id, or the function name resolved for an
+ * offset within it. */
+struct cache_entry
+{
+    char *build_id;
+    bool symbol;
+    /* Symbol entries only. */
+    uint64_t offset;
+    /* The path of the file, or the function name. */
+    char *name;
+    /* File entries only. */
+    struct file_stamp file_stamp;
+    struct cache_entry *prev;
+    struct cache_entry *next;
+};
+
+/* LRU cache of the files and symbols.  The entries are kept in a doubly
+ * linked list ordered from the most recently used one, the hash tables
+ * map the build ids and the (build id, offset) pairs to the entries. */
+static struct
+{
+    pthread_mutex_t lock;
+    struct hash_table *files;
+    struct hash_table *symbols;
+    struct cache_entry *head;
+    struct cache_entry *tail;
+    size_t size;
+    size_t capacity;
+    unsigned long hits;
+    unsigned long misses;
+} cache = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .capacity = BUILD_ID_CACHE_CAPACITY,
+};
+
+static size_t
+hash_file_entry(const void *key)
+{
+    return hash_string(((const struct cache_entry *)key)->build_id);
+}
+
+static bool
+file_entry_equal(const void *key1, const void *key2)
+{
+    return string_equal(((const struct cache_entry *)key1)->build_id,
+                        ((const struct cache_entry *)key2)->build_id);
+}
+
+static size_t
+hash_symbol_entry(const void *key)
+{
+    const struct cache_entry *entry = key;
+    return hash_string(entry->build_id) * 31
+        ^ hash_bytes(&entry->offset, sizeof(entry->offset));
+}
+
+static bool
+symbol_entry_equal(const void *key1, const void *key2)
+{
+    const struct cache_entry *entry1 = key1, *entry2 = key2;
+    return entry1->offset == entry2->offset
+        && string_equal(entry1->build_id, entry2->build_id);
+}
+
+static void
+cache_unlink(struct cache_entry *entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        cache.head = entry->next;
+
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        cache.tail = entry->prev;
+}
+
+static void
+cache_push_front(struct cache_entry *entry)
+{
+    entry->prev = NULL;
+    entry->next = cache.head;
+    if (cache.head)
+        cache.head->prev = entry;
+    else
+        cache.tail = entry;
+
+    cache.head = entry;
+}
+
+/* Removes the entry from its table and the list and releases it.  Must
+ * be called with the lock held. */
+static void
+cache_remove(struct cache_entry *entry)
+{
+    hash_table_remove(entry->symbol ? cache.symbols : cache.files, entry);
+    cache_unlink(entry);
+    --cache.size;
+    free(entry->build_id);
+    free(entry->name);
+    free(entry);
+}
+
+/* Drops the least recently used entries until at most capacity remain.
+ * Must be called with the lock held. */
+static void
+cache_shrink(size_t capacity)
+{
+    while (cache.size > capacity)
+        cache_remove(cache.tail);
+}
+
+/* Returns the stored entry equal to the key and marks it as the most
+ * recently used one, or NULL.  Must be called with the lock held. */
+static struct cache_entry *
+cache_lookup(const struct cache_entry *key)
+{
+    struct hash_table *table = (key->symbol ? cache.symbols : cache.files);
+    void *entry;
+    if (!table || !hash_table_lookup(table, key, &entry))
+        return NULL;
+
+    cache_unlink(entry);
+    cache_push_front(entry);
+    return entry;
+}
+
+/* Stores a new entry with a copy of the key and the name, replacing an
+ * equal one.  Returns NULL if the cache is disabled.  Must be called with
+ * the lock held. */
+static struct cache_entry *
+cache_insert(const struct cache_entry *key, const char *name)
+{
+    if (cache.capacity == 0)
+        return NULL;
+
+    struct cache_entry *entry = cache_lookup(key);
+    if (entry)
+    {
+        free(entry->name);
+        entry->name = sr_strdup(name);
+        return entry;
+    }
+
+    if (!cache.files)
+    {
+        cache.files = hash_table_new(hash_file_entry, file_entry_equal,
+                                     NULL, NULL);
+        cache.symbols = hash_table_new(hash_symbol_entry, symbol_entry_equal,
+                                       NULL, NULL);
+    }
+
+    cache_shrink(cache.capacity - 1);
+
+    entry = sr_mallocz(sizeof(*entry));
+    entry->build_id = sr_strdup(key->build_id);
+    entry->symbol = key->symbol;
+    entry->offset = key->offset;
+    entry->name = sr_strdup(name);
+    hash_table_insert(entry->symbol ? cache.symbols : cache.files,
+                      entry, entry);
+    cache_push_front(entry);
+    ++cache.size;
+    return entry;
+}
+
+static bool
+get_file_stamp(const char *file_name, struct file_stamp *stamp)
+{
+    struct stat st;
+    if (stat(file_name, &st) != 0)
+        return false;
+
+    stamp->device = st.st_dev;
+    stamp->inode = st.st_ino;
+    stamp->size = st.st_size;
+    stamp->mtime = st.st_mtim;
+    return true;
+}
+
+static bool
+file_stamp_equal(const struct file_stamp *stamp1,
+                 const struct file_stamp *stamp2)
+{
+    return stamp1->device == stamp2->device
+        && stamp1->inode == stamp2->inode
+        && stamp1->size == stamp2->size
+        && stamp1->mtime.tv_sec == stamp2->mtime.tv_sec
+        && stamp1->mtime.tv_nsec == stamp2->mtime.tv_nsec;
+}
+
+bool
+build_id_cache_find_file(const char *build_id,
+                         char **file_name)
+{
+    struct cache_entry key = { .build_id = (char *)build_id };
+
+    pthread_mutex_lock(&cache.lock);
+
+    struct cache_entry *entry = cache_lookup(&key);
+    char *name = NULL;
+    struct file_stamp cached_stamp;
+    if (entry)
+    {
+        name = sr_strdup(entry->name);
+        cached_stamp = entry->file_stamp;
+    }
+
+    pthread_mutex_unlock(&cache.lock);
+
+    /* Check the file without holding the lock. */
+    struct file_stamp stamp;
+    bool found = (name && get_file_stamp(name, &stamp)
+                  && file_stamp_equal(&stamp, &cached_stamp));
+
+    pthread_mutex_lock(&cache.lock);
+    if (found)
+        ++cache.hits;
+    else
+    {
+        ++cache.misses;
+
+        /* Forget the stale path, unless it has been replaced meanwhile. */
+        entry = (name ? cache_lookup(&key) : NULL);
+        if (entry && 0 == strcmp(entry->name, name))
+            cache_remove(entry);
+
+        free(name);
+        name = NULL;
+    }
+
+    pthread_mutex_unlock(&cache.lock);
+    *file_name = name;
+    return found;
+}
+
+void
+build_id_cache_set_file(const char *build_id,
+                        const char *file_name)
+{
+    struct file_stamp stamp;
+    if (!get_file_stamp(file_name, &stamp))
+        return;
+
+    struct cache_entry key = { .build_id = (char *)build_id };
+
+    pthread_mutex_lock(&cache.lock);
+    struct cache_entry *entry = cache_insert(&key, file_name);
+    if (entry)
+        entry->file_stamp = stamp;
+
+    pthread_mutex_unlock(&cache.lock);
+}
+
+bool
+build_id_cache_find_symbol(const char *build_id,
+                           uint64_t offset,
+                           char **function_name)
+{
+    struct cache_entry key = {
+        .build_id = (char *)build_id,
+        .symbol = true,
+        .offset = offset,
+    };
+
+    pthread_mutex_lock(&cache.lock);
+
+    struct cache_entry *entry = cache_lookup(&key);
+    if (entry)
+    {
+        ++cache.hits;
+        *function_name = sr_strdup(entry->name);
+    }
+    else
+        ++cache.misses;
+
+    pthread_mutex_unlock(&cache.lock);
+    return entry != NULL;
+}
+
+void
+build_id_cache_set_symbol(const char *build_id,
+                          uint64_t offset,
+                          const char *function_name)
+{
+    if (!function_name)
+        return;
+
+    struct cache_entry key = {
+        .build_id = (char *)build_id,
+        .symbol = true,
+        .offset = offset,
+    };
+
+    pthread_mutex_lock(&cache.lock);
+    cache_insert(&key, function_name);
+    pthread_mutex_unlock(&cache.lock);
+}
+
+void
+sr_build_id_cache_set_capacity(size_t capacity)
+{
+    pthread_mutex_lock(&cache.lock);
+    cache.capacity = capacity;
+    cache_shrink(capacity);
+    pthread_mutex_unlock(&cache.lock);
+}
+
+void
+sr_build_id_cache_clear(void)
+{
+    pthread_mutex_lock(&cache.lock);
+    cache_shrink(0);
+    hash_table_free(cache.files);
+    hash_table_free(cache.symbols);
+    cache.files = cache.symbols = NULL;
+    cache.hits = 0;
+    cache.misses = 0;
+    pthread_mutex_unlock(&cache.lock);
+}
+
+void
+sr_build_id_cache_get_stats(struct sr_build_id_cache_stats *stats)
+{
+    pthread_mutex_lock(&cache.lock);
+    stats->hits = cache.hits;
+    stats->misses = cache.misses;
+    stats->size = cache.size;
+    stats->capacity = cache.capacity;
+    pthread_mutex_unlock(&cache.lock);
+}
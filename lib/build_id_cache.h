@@ -0,0 +1,87 @@
+/*
+    build_id_cache.h
+
+    Copyright (C) 2013  Red Hat, Inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef SATYR_BUILD_ID_CACHE_H
+#define SATYR_BUILD_ID_CACHE_H
+
+/**
+ * @file
+ * @brief Process-wide cache of ELF metadata keyed by build id.
+ *
+ * Processing many coredumps of the same program version resolves the
+ * same modules over and over.  The cache remembers where the ELF file
+ * with a given build id was found and the function names resolved for
+ * offsets within it, so that later coredumps can skip the lookups.  The
+ * cache is bounded, see sr_build_id_cache_set_capacity().  All functions
+ * are thread-safe.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Looks up the ELF file previously found for the build id.  Returns
+ * false if the build id is unknown, or if the file has been removed or
+ * modified since it was stored; such a path is forgotten.  Otherwise
+ * stores a copy of the file name to *file_name.
+ */
+bool
+build_id_cache_find_file(const char *build_id,
+                         char **file_name);
+
+/**
+ * Remembers the ELF file found for the build id, together with the
+ * identity of the file at this moment.  Files that cannot be examined by
+ * stat() are not stored.  Failed lookups are never stored, so that a
+ * file installed later is found.
+ */
+void
+build_id_cache_set_file(const char *build_id,
+                        const char *file_name);
+
+/**
+ * Looks up the function name resolved for the offset from the start of
+ * the module with the build id.  Returns false if the offset is unknown.
+ * Otherwise stores a copy of the function name to *function_name.
+ */
+bool
+build_id_cache_find_symbol(const char *build_id,
+                           uint64_t offset,
+                           char **function_name);
+
+/**
+ * Remembers the function name resolved for the offset from the start of
+ * the module with the build id.  A NULL function_name, an address that
+ * could not be resolved, is not stored, so that the address is resolved
+ * again once the ELF file of the module is available.
+ */
+void
+build_id_cache_set_symbol(const char *build_id,
+                          uint64_t offset,
+                          const char *function_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
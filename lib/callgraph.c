@@ -79,7 +79,7 @@ sr_callgraph_extend(struct sr_callgraph *callgraph,
 
     struct sr_elf_fde *fde =
         sr_elf_find_fde_for_start_address(eh_frame,
-                                           start_address);
+                                          start_address);
 
     if (!fde)
     {
@@ -122,10 +122,10 @@ sr_callgraph_extend(struct sr_callgraph *callgraph,
     while (*callees != 0)
     {
         struct sr_callgraph *result = sr_callgraph_extend(callgraph,
-                                                            *callees,
-                                                            disassembler,
-                                                            eh_frame,
-                                                            error_message);
+                                                          *callees,
+                                                          disassembler,
+                                                          eh_frame,
+                                                          error_message);
 
         /* Failure here may mean that the address points to PLT. */
         if (result)
@@ -142,7 +142,6 @@ sr_callgraph_extend(struct sr_callgraph *callgraph,
     return callgraph;
 }
 
-
 void
 sr_callgraph_free(struct sr_callgraph *callgraph)
 {
@@ -52,6 +52,7 @@ struct stacktrace_methods core_stacktrace_methods =
     /* core parser returns error_message directly */
     .parse = (parse_fn_t) sr_core_stacktrace_from_json_text,
     .parse_location = (parse_location_fn_t) NULL,
+    .parse_n = (parse_n_fn_t) sr_core_stacktrace_from_json_text_n,
     .to_short_text = (to_short_text_fn_t) stacktrace_to_short_text,
     .to_json = (to_json_fn_t) sr_core_stacktrace_to_json,
     .from_json = (from_json_fn_t) sr_core_stacktrace_from_json,
@@ -229,6 +230,23 @@ sr_core_stacktrace_from_json_text(const char *text,
     return stacktrace;
 }
 
+struct sr_core_stacktrace *
+sr_core_stacktrace_from_json_text_n(const char *text,
+                                    size_t length,
+                                    char **error_message)
+{
+    struct sr_json_value *json_root = sr_json_parse_n(text, length,
+                                                      error_message);
+    if (!json_root)
+        return NULL;
+
+    struct sr_core_stacktrace *stacktrace =
+        sr_core_stacktrace_from_json(json_root, error_message);
+
+    sr_json_value_free(json_root);
+    return stacktrace;
+}
+
 char *
 sr_core_stacktrace_to_json(struct sr_core_stacktrace *stacktrace)
 {
@@ -24,6 +24,7 @@
 #include <fcntl.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
 #include <sys/procfs.h> /* struct elf_prstatus */
 #include <sys/ptrace.h> /* PTRACE_SEIZE */
 
@@ -33,6 +34,8 @@
 #include "core/unwind.h"
 #include "internal_unwind.h"
 #include "internal_utils.h"
+#include "hash_table.h"
+#include "build_id_cache.h"
 
 #include "location.h"
 #include "gdb/frame.h"
@@ -53,6 +56,17 @@ sr_parse_coredump(const char *coredump_filename,
     return NULL;
 }
 
+struct sr_core_stacktrace *
+sr_parse_coredump_ex(const char *coredump_filename,
+                     const char *executable_filename,
+                     const struct sr_core_unwind_options *options,
+                     char **error_message)
+{
+    return sr_parse_coredump(coredump_filename,
+                             executable_filename,
+                             error_message);
+}
+
 #endif /* !defined WITH_LIBDWFL && !defined WITH_LIBUNWIND */
 
 #if (!defined WITH_LIBDWFL || !defined PTRACE_SEIZE)
@@ -69,9 +83,22 @@ sr_core_stacktrace_from_core_hook(pid_t thread_id,
 
 #endif /* !defined WITH_LIBDWFL || !defined PTRACE_SEIZE */
 
-/* FIXME: is there another way to pass the executable name to the find_elf
- * callback? */
-const char *executable_file = NULL;
+/* The executable of the coredump being opened by the calling thread.  The
+ * find_elf callback gets no data of the caller, so open_coredump passes
+ * the executable to it through this variable.  It is set only while the
+ * modules are reported and their ELF files are found, which all happens
+ * within open_coredump, so concurrent calls do not see each other's
+ * executable. */
+static __thread const char *executable_file;
+
+static pthread_once_t elf_version_once = PTHREAD_ONCE_INIT;
+static bool elf_version_ok;
+
+static void
+elf_version_init(void)
+{
+    elf_version_ok = (elf_version(EV_CURRENT) != EV_NONE);
+}
 
 void
 _set_error(char **error_msg, const char *fmt, ...)
@@ -101,6 +128,8 @@ core_handle_free(struct core_handle *ch)
             seg = next;
         }
 
+        resolve_cache_free(ch->cache);
+        sr_core_segment_index_free(ch->segment_index);
         if (ch->dwfl)
             dwfl_end(ch->dwfl);
         if (ch->eh)
@@ -111,13 +140,34 @@ core_handle_free(struct core_handle *ch)
     }
 }
 
+/* Opens the ELF file found earlier for the same build id. */
+static int
+open_elf(const char *path, char **file_name, Elf **elfp)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    *elfp = elf_begin(fd, ELF_C_READ_MMAP, NULL);
+    if (*elfp == NULL)
+    {
+        warn("Unable to open '%s': %s", path, elf_errmsg(-1));
+        close(fd);
+        return -1;
+    }
+
+    *file_name = sr_strdup(path);
+    return fd;
+}
+
 static int
 find_elf_core (Dwfl_Module *mod, void **userdata, const char *modname,
                Dwarf_Addr base, char **file_name, Elf **elfp)
 {
     int ret = -1;
 
-    if (strcmp("[exe]", modname) == 0 || strcmp("[pie]", modname) == 0)
+    if (executable_file &&
+        (strcmp("[exe]", modname) == 0 || strcmp("[pie]", modname) == 0))
     {
         int fd = open(executable_file, O_RDONLY);
         if (fd < 0)
@@ -137,8 +187,36 @@ find_elf_core (Dwfl_Module *mod, void **userdata, const char *modname,
     }
     else
     {
-        ret = dwfl_build_id_find_elf(mod, userdata, modname, base,
-                                     file_name, elfp);
+        /* The build id comes from the coredump notes, so it is known
+         * before the ELF file is found. */
+        const unsigned char *build_id_bits;
+        GElf_Addr build_id_addr;
+        int len = dwfl_module_build_id(mod, &build_id_bits, &build_id_addr);
+        if (len <= 0)
+            return dwfl_build_id_find_elf(mod, userdata, modname, base,
+                                          file_name, elfp);
+
+        char *build_id = sr_mallocz(2*len + 1);
+        sr_bin2hex(build_id, (const char *)build_id_bits, len);
+
+        char *cached_name;
+        if (build_id_cache_find_file(build_id, &cached_name))
+        {
+            ret = open_elf(cached_name, file_name, elfp);
+            free(cached_name);
+        }
+
+        /* Missing files are looked up again every time, as they may have
+         * been installed meanwhile. */
+        if (ret < 0)
+        {
+            ret = dwfl_build_id_find_elf(mod, userdata, modname, base,
+                                         file_name, elfp);
+            if (ret >= 0 && *file_name)
+                build_id_cache_set_file(build_id, *file_name);
+        }
+
+        free(build_id);
     }
 
     return ret;
@@ -154,14 +232,147 @@ find_debuginfo_none (Dwfl_Module *mod, void **userdata, const char *modname,
     return -1;
 }
 
+struct segment_entry
+{
+    struct sr_core_segment segment;
+    /* NULL once the Dwfl the index was built from is gone. */
+    Dwfl_Module *module;
+};
+
+struct sr_core_segment_index
+{
+    /* Sorted by segment.start once the index is built. */
+    struct segment_entry *entries;
+    size_t count;
+    size_t allocated;
+};
+
+struct sr_core_segment_index *
+segment_index_new(void)
+{
+    return sr_mallocz(sizeof(struct sr_core_segment_index));
+}
+
+void
+segment_index_add(struct sr_core_segment_index *index, Dwfl_Module *mod,
+                  Dwarf_Addr start, Dwarf_Addr end, const char *filename)
+{
+    if (index->count == index->allocated)
+    {
+        index->allocated = (index->allocated ? 2 * index->allocated : 64);
+        index->entries = sr_realloc_array(index->entries, index->allocated,
+                                          sizeof(*index->entries));
+    }
+
+    struct segment_entry *entry = &index->entries[index->count++];
+    entry->segment.start = start;
+    entry->segment.end = end;
+    entry->segment.file_name = sr_strdup(filename);
+    entry->segment.build_id = NULL;
+    entry->module = mod;
+
+    const unsigned char *build_id_bits;
+    GElf_Addr build_id_addr;
+    int len = (mod ? dwfl_module_build_id(mod, &build_id_bits, &build_id_addr)
+                   : 0);
+    if (len > 0)
+    {
+        entry->segment.build_id = sr_mallocz(2*len + 1);
+        sr_bin2hex(entry->segment.build_id, (const char *)build_id_bits, len);
+    }
+}
+
+static int
+segment_entry_cmp(const void *a, const void *b)
+{
+    const struct segment_entry *e1 = a, *e2 = b;
+    if (e1->segment.start != e2->segment.start)
+        return (e1->segment.start < e2->segment.start ? -1 : 1);
+
+    return 0;
+}
+
+void
+segment_index_sort(struct sr_core_segment_index *index)
+{
+    qsort(index->entries, index->count, sizeof(*index->entries),
+          segment_entry_cmp);
+}
+
+/* Dwfl does not report overlapping modules, so no two segments contain
+ * the same address. */
+static const struct segment_entry *
+segment_index_find_entry(const struct sr_core_segment_index *index,
+                         uint64_t address)
+{
+    size_t low = 0, high = index->count;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (index->entries[middle].segment.start <= address)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if (low > 0 && address < index->entries[low - 1].segment.end)
+        return &index->entries[low - 1];
+
+    return NULL;
+}
+
+void
+sr_core_segment_index_free(struct sr_core_segment_index *index)
+{
+    if (!index)
+        return;
+
+    for (size_t i = 0; i < index->count; ++i)
+    {
+        free(index->entries[i].segment.file_name);
+        free(index->entries[i].segment.build_id);
+    }
+
+    free(index->entries);
+    free(index);
+}
+
+size_t
+sr_core_segment_index_count(const struct sr_core_segment_index *index)
+{
+    return index->count;
+}
+
+const struct sr_core_segment *
+sr_core_segment_index_get(const struct sr_core_segment_index *index,
+                          size_t i)
+{
+    assert(i < index->count);
+    return &index->entries[i].segment;
+}
+
+const struct sr_core_segment *
+sr_core_segment_index_find(const struct sr_core_segment_index *index,
+                           uint64_t address)
+{
+    const struct segment_entry *entry = segment_index_find_entry(index, address);
+    return (entry ? &entry->segment : NULL);
+}
+
+struct touch_module_arg
+{
+    struct exe_mapping_data **tail;
+    struct sr_core_segment_index *index;
+};
+
 static int
 touch_module(Dwfl_Module *mod, void **userdata, const char *name,
              Dwarf_Addr start_addr, void *arg)
 {
-    struct exe_mapping_data ***tailp = arg;
+    struct touch_module_arg *touch_arg = arg;
     const char *filename = NULL;
     GElf_Addr bias;
-    Dwarf_Addr base;
+    Dwarf_Addr base, end;
 
     if (dwfl_module_getelf (mod, &bias) == NULL)
     {
@@ -169,14 +380,16 @@ touch_module(Dwfl_Module *mod, void **userdata, const char *name,
         return DWARF_CB_OK;
     }
 
-    dwfl_module_info(mod, NULL, &base, NULL, NULL, NULL, &filename, NULL);
+    dwfl_module_info(mod, NULL, &base, &end, NULL, NULL, &filename, NULL);
 
     if (filename)
     {
-        **tailp = sr_mallocz(sizeof(struct exe_mapping_data));
-        (**tailp)->start = (uint64_t)base;
-        (**tailp)->filename = sr_strdup(filename);
-        *tailp = &((**tailp)->next);
+        *touch_arg->tail = sr_mallocz(sizeof(struct exe_mapping_data));
+        (*touch_arg->tail)->start = (uint64_t)base;
+        (*touch_arg->tail)->filename = sr_strdup(filename);
+        touch_arg->tail = &(*touch_arg->tail)->next;
+
+        segment_index_add(touch_arg->index, mod, base, end, filename);
     }
 
     return DWARF_CB_OK;
@@ -186,10 +399,11 @@ struct core_handle *
 open_coredump(const char *elf_file, const char *exe_file, char **error_msg)
 {
     struct core_handle *ch = sr_mallocz(sizeof(*ch));
-    struct exe_mapping_data *head = NULL, **tail = &head;
+    struct exe_mapping_data *head = NULL;
 
     /* Initialize libelf, open the file and get its Elf handle. */
-    if (elf_version(EV_CURRENT) == EV_NONE)
+    pthread_once(&elf_version_once, elf_version_init);
+    if (!elf_version_ok)
     {
         set_error_elf("elf_version");
         goto fail_free;
@@ -241,7 +455,9 @@ open_coredump(const char *elf_file, const char *exe_file, char **error_msg)
     }
 
     /* needed so that module filenames are available during unwinding */
-    ptrdiff_t ret = dwfl_getmodules(ch->dwfl, touch_module, &tail, 0);
+    struct touch_module_arg touch_arg = { &head, segment_index_new() };
+    ch->segment_index = touch_arg.index;
+    ptrdiff_t ret = dwfl_getmodules(ch->dwfl, touch_module, &touch_arg, 0);
     if (ret == -1)
     {
         set_error_dwfl("dwfl_getmodules");
@@ -249,6 +465,8 @@ open_coredump(const char *elf_file, const char *exe_file, char **error_msg)
     }
     ch->segments = head;
 
+    segment_index_sort(ch->segment_index);
+
     if (!head)
     {
         if (error_msg && !*error_msg)
@@ -256,9 +474,13 @@ open_coredump(const char *elf_file, const char *exe_file, char **error_msg)
         goto fail_dwfl;
     }
 
+    executable_file = NULL;
+    ch->cache = resolve_cache_new(ch->segment_index);
     return ch;
 
 fail_dwfl:
+    executable_file = NULL;
+    sr_core_segment_index_free(ch->segment_index);
     dwfl_end(ch->dwfl);
 fail_elf:
     elf_end(ch->eh);
@@ -270,8 +492,161 @@ fail_free:
     return NULL;
 }
 
+struct sr_core_segment_index *
+sr_core_segment_index_from_coredump(const char *coredump_filename,
+                                    const char *executable_filename,
+                                    char **error_message)
+{
+    char *error_msg = NULL;
+    struct core_handle *ch = open_coredump(coredump_filename,
+                                           executable_filename, &error_msg);
+    if (!ch)
+    {
+        if (error_message)
+            *error_message = error_msg;
+        else
+            free(error_msg);
+
+        return NULL;
+    }
+
+    /* The modules go away with the dwfl. */
+    struct sr_core_segment_index *index = ch->segment_index;
+    for (size_t i = 0; i < index->count; ++i)
+        index->entries[i].module = NULL;
+
+    ch->segment_index = NULL;
+    core_handle_free(ch);
+    return index;
+}
+
+/* What resolve_frame() needs to know about a module. */
+struct module_info
+{
+    char *build_id;
+    /* NULL if dwfl_module_info failed. */
+    char *file_name;
+    Dwarf_Addr start;
+};
+
+struct symbol_key
+{
+    Dwfl_Module *module;
+    Dwarf_Addr address;
+};
+
+struct resolve_cache
+{
+    /* Dwfl_Module * -> struct module_info * */
+    struct hash_table *modules;
+    /* struct symbol_key * -> demangled function name or NULL */
+    struct hash_table *symbols;
+    /* Modules of the dwfl by address, may be NULL. */
+    const struct sr_core_segment_index *segments;
+};
+
+static struct module_info *
+module_info_new(Dwfl_Module *mod)
+{
+    struct module_info *info = sr_mallocz(sizeof(*info));
+    const unsigned char *build_id_bits;
+    const char *filename;
+    GElf_Addr bias, bid_addr;
+
+    /* Initialize the module's main Elf for dwfl_module_build_id and dwfl_module_info */
+    /* No need to deallocate the variable 'bias' and the return value.*/
+    if (NULL == dwfl_module_getelf(mod, &bias))
+        warn("The module's main Elf was not found");
+
+    int ret = dwfl_module_build_id(mod, &build_id_bits, &bid_addr);
+    if (ret > 0)
+    {
+        info->build_id = sr_mallocz(2*ret + 1);
+        sr_bin2hex(info->build_id, (const char *)build_id_bits, ret);
+    }
+
+    const char *modname = dwfl_module_info(mod, NULL, &info->start, NULL, NULL,
+                                           NULL, &filename, NULL);
+    if (modname)
+        info->file_name = filename ? sr_strdup(filename) : sr_strdup(modname);
+
+    return info;
+}
+
+static void
+module_info_free(void *data)
+{
+    struct module_info *info = data;
+    if (!info)
+        return;
+
+    free(info->build_id);
+    free(info->file_name);
+    free(info);
+}
+
+static char *
+function_name_new(Dwfl_Module *mod, Dwarf_Addr address)
+{
+    const char *funcname = dwfl_module_addrname(mod, (GElf_Addr)address);
+    if (!funcname)
+        return NULL;
+
+    char *demangled = sr_demangle_symbol(funcname);
+    return (demangled ? demangled : sr_strdup(funcname));
+}
+
+static size_t
+hash_pointer(const void *key)
+{
+    return hash_bytes(&key, sizeof(key));
+}
+
+static bool
+pointer_equal(const void *key1, const void *key2)
+{
+    return key1 == key2;
+}
+
+static size_t
+hash_symbol_key(const void *key)
+{
+    return hash_bytes(key, sizeof(struct symbol_key));
+}
+
+static bool
+symbol_key_equal(const void *key1, const void *key2)
+{
+    const struct symbol_key *k1 = key1, *k2 = key2;
+    return k1->module == k2->module && k1->address == k2->address;
+}
+
+struct resolve_cache *
+resolve_cache_new(const struct sr_core_segment_index *segments)
+{
+    struct resolve_cache *cache = sr_malloc(sizeof(*cache));
+    cache->segments = segments;
+    cache->modules = hash_table_new(hash_pointer, pointer_equal,
+                                    NULL, module_info_free);
+    cache->symbols = hash_table_new(hash_symbol_key, symbol_key_equal,
+                                    free, free);
+    return cache;
+}
+
+void
+resolve_cache_free(struct resolve_cache *cache)
+{
+    if (!cache)
+        return;
+
+    hash_table_free(cache->modules);
+    hash_table_free(cache->symbols);
+    free(cache);
+}
+
 struct sr_core_frame *
-resolve_frame(Dwfl *dwfl, Dwarf_Addr ip, bool minus_one)
+resolve_frame(Dwfl *dwfl, Dwarf_Addr ip, bool minus_one,
+              struct resolve_cache *cache)
 {
     struct sr_core_frame *frame = sr_core_frame_new();
     frame->address = frame->build_id_offset = (uint64_t)ip;
@@ -279,49 +654,82 @@ resolve_frame(Dwfl *dwfl, Dwarf_Addr ip, bool minus_one)
     /* see dwfl_frame_state_pc for meaning of this parameter */
     Dwarf_Addr ip_adjusted = ip - (minus_one ? 1 : 0);
 
-    Dwfl_Module *mod = dwfl_addrmodule(dwfl, ip_adjusted);
-    if (mod)
+    /* The segment index only holds the modules with an ELF file, ask
+     * dwfl about the rest. */
+    const struct segment_entry *segment = NULL;
+    if (cache && cache->segments)
+        segment = segment_index_find_entry(cache->segments, ip_adjusted);
+
+    Dwfl_Module *mod = (segment ? segment->module
+                                : dwfl_addrmodule(dwfl, ip_adjusted));
+    if (!mod)
+        return frame;
+
+    /* Threads of a process share most of their modules and often the
+     * call chains too, so the module information and the demangled
+     * names are looked up once per coredump when a cache is given. */
+    struct module_info *info;
+    if (!cache || !hash_table_lookup(cache->modules, mod, (void **)&info))
     {
-        int ret;
-        const unsigned char *build_id_bits;
-        const char *filename, *funcname;
-        GElf_Addr bias, bid_addr;
-        Dwarf_Addr start;
+        info = module_info_new(mod);
+        if (cache)
+            hash_table_insert(cache->modules, mod, info);
+    }
 
-        /* Initialize the module's main Elf for dwfl_module_build_id and dwfl_module_info */
-        /* No need to deallocate the variable 'bias' and the return value.*/
-        if (NULL == dwfl_module_getelf(mod, &bias))
-            warn("The module's main Elf was not found");
+    if (info->build_id)
+        frame->build_id = sr_strdup(info->build_id);
 
-        ret = dwfl_module_build_id(mod, &build_id_bits, &bid_addr);
-        if (ret > 0)
-        {
-            frame->build_id = sr_mallocz(2*ret + 1);
-            sr_bin2hex(frame->build_id, (const char *)build_id_bits, ret);
-        }
+    if (info->file_name)
+    {
+        frame->build_id_offset = ip - info->start;
+        frame->file_name = sr_strdup(info->file_name);
+    }
 
-        const char *modname = dwfl_module_info(mod, NULL, &start, NULL, NULL, NULL,
-                                               &filename, NULL);
+    if (!cache)
+    {
+        frame->function_name = function_name_new(mod, ip_adjusted);
+        module_info_free(info);
+        return frame;
+    }
 
-        if (modname)
+    struct symbol_key key = { .module = mod, .address = ip_adjusted };
+    char *function_name;
+    if (!hash_table_lookup(cache->symbols, &key, (void **)&function_name))
+    {
+        /* Other coredumps of the same binaries may have resolved the
+         * address already. */
+        uint64_t offset = ip_adjusted - info->start;
+        if (!info->build_id
+            || !build_id_cache_find_symbol(info->build_id, offset,
+                                           &function_name))
         {
-            frame->build_id_offset = ip - start;
-            frame->file_name = filename ? sr_strdup(filename) : sr_strdup(modname);
+            /* An address that cannot be resolved is not shared, the ELF
+             * file may be found for a later coredump. */
+            function_name = function_name_new(mod, ip_adjusted);
+            if (info->build_id && function_name)
+                build_id_cache_set_symbol(info->build_id, offset,
+                                          function_name);
         }
 
-        funcname = dwfl_module_addrname(mod, (GElf_Addr)ip_adjusted);
-        if (funcname)
-        {
-            char *demangled = sr_demangle_symbol(funcname);
-            frame->function_name = (demangled ? demangled : sr_strdup(funcname));
-        }
+        struct symbol_key *stored_key = sr_malloc(sizeof(*stored_key));
+        *stored_key = key;
+        hash_table_insert(cache->symbols, stored_key, function_name);
     }
 
+    if (function_name)
+        frame->function_name = sr_strdup(function_name);
+
     return frame;
 }
 
 short
 get_signal_number(Elf *e, const char *elf_file)
+{
+    return get_signal_and_tid(e, elf_file, NULL);
+}
+
+short
+get_signal_and_tid(Elf *e, const char *elf_file, pid_t *tid)
 {
     const char NOTE_CORE[] = "CORE";
 
@@ -396,13 +804,56 @@ get_signal_number(Elf *e, const char *elf_file)
             struct elf_prstatus *prstatus = (struct elf_prstatus*)desc_data->d_buf;
             short signal = prstatus->pr_cursig;
             if (signal)
+            {
+                if (tid)
+                    *tid = prstatus->pr_pid;
                 return signal;
+            }
         }
     }
 
     return 0;
 }
 
+bool
+unwound_threads_merge(struct sr_core_thread **results, char **errors,
+                      size_t count, struct sr_core_thread **threads,
+                      char **error_msg)
+{
+    /* Report the first failure in thread order, like the sequential
+     * unwinding does. */
+    size_t failed = count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!results[i])
+        {
+            failed = i;
+            break;
+        }
+    }
+
+    if (failed < count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            sr_core_thread_free(results[i]);
+
+        *threads = NULL;
+        set_error("%s", errors[failed] ? errors[failed]
+                                       : "Failed to unwind threads");
+        return false;
+    }
+
+    struct sr_core_thread **tail = threads;
+    for (size_t i = 0; i < count; ++i)
+    {
+        *tail = results[i];
+        tail = &results[i]->next;
+    }
+
+    *tail = NULL;
+    return true;
+}
+
 struct sr_core_stacktrace *
 sr_core_stacktrace_from_gdb(const char *gdb_output, const char *core_file,
                             const char *exe_file, char **error_msg)
@@ -444,7 +895,7 @@ sr_core_stacktrace_from_gdb(const char *gdb_output, const char *core_file,
                 continue;
 
             struct sr_core_frame *core_frame = resolve_frame(ch->dwfl,
-                    gdb_frame->address, false);
+                    gdb_frame->address, false, ch->cache);
 
             core_thread->frames = sr_core_frame_append(core_thread->frames,
                     core_frame);
@@ -22,6 +22,7 @@
 #include "core/frame.h"
 #include "core/thread.h"
 #include "core/stacktrace.h"
+#include "core/unwind.h"
 #include "internal_unwind.h"
 
 #ifdef WITH_LIBDWFL
@@ -30,6 +31,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
 #include <sys/ptrace.h>
 #include <sys/wait.h>
 
@@ -40,12 +42,15 @@ struct frame_callback_arg
     struct sr_core_frame **frames_tail;
     char *error_msg;
     unsigned nframes;
+    /* May be NULL. */
+    struct resolve_cache *cache;
 };
 
 struct thread_callback_arg
 {
     struct sr_core_thread **threads_tail;
     char *error_msg;
+    struct resolve_cache *cache;
 };
 
 static const int CB_STOP_UNWIND = DWARF_CB_ABORT+1;
@@ -65,7 +70,7 @@ frame_callback(Dwfl_Frame *frame, void *data)
     }
 
     Dwfl *dwfl = dwfl_thread_dwfl(dwfl_frame_thread(frame));
-    struct sr_core_frame *result = resolve_frame(dwfl, pc, minus_one);
+    struct sr_core_frame *result = resolve_frame(dwfl, pc, minus_one, frame_arg->cache);
 
     /* Do not unwind below __libc_start_main. */
     if (0 == sr_strcmp0(result->function_name, "__libc_start_main"))
@@ -94,28 +99,34 @@ truncate_long_thread(struct sr_core_thread *thread, struct frame_callback_arg *f
     }
 }
 
-static int
-unwind_thread(Dwfl_Thread *thread, void *data)
+/* Unwinds the given thread, or the thread with the given tid if thread is
+ * NULL.  Returns NULL and sets *error_msg on failure. */
+static struct sr_core_thread *
+unwind_thread_frames(Dwfl *dwfl, struct resolve_cache *cache,
+                     Dwfl_Thread *thread, pid_t tid, char **error_msg)
 {
-    struct thread_callback_arg *thread_arg = data;
-    char **error_msg = &thread_arg->error_msg;
-
     struct sr_core_thread *result = sr_core_thread_new();
     if (!result)
     {
         set_error("Failed to initialize thread memory");
-        return DWARF_CB_ABORT;
+        return NULL;
     }
-    result->id = (int64_t)dwfl_thread_tid(thread);
+    result->id = (int64_t)(thread ? dwfl_thread_tid(thread) : tid);
 
     struct frame_callback_arg frame_arg =
     {
         .frames_tail = &(result->frames),
         .error_msg = NULL,
-        .nframes = 0
+        .nframes = 0,
+        .cache = cache
     };
 
-    int ret = dwfl_thread_getframes(thread, frame_callback, &frame_arg);
+    int ret;
+    if (thread)
+        ret = dwfl_thread_getframes(thread, frame_callback, &frame_arg);
+    else
+        ret = dwfl_getthread_frames(dwfl, tid, frame_callback, &frame_arg);
+
     if (ret == -1)
     {
         warn("dwfl_thread_getframes failed for thread id %d: %s",
@@ -139,23 +150,273 @@ unwind_thread(Dwfl_Thread *thread, void *data)
     }
 
     truncate_long_thread(result, &frame_arg);
+    return result;
+
+abort:
+    sr_core_thread_free(result);
+    return NULL;
+}
+
+static int
+unwind_thread(Dwfl_Thread *thread, void *data)
+{
+    struct thread_callback_arg *thread_arg = data;
+
+    struct sr_core_thread *result =
+        unwind_thread_frames(NULL, thread_arg->cache, thread, 0,
+                             &thread_arg->error_msg);
+    if (!result)
+        return DWARF_CB_ABORT;
 
     *thread_arg->threads_tail = result;
     thread_arg->threads_tail = &result->next;
 
     return DWARF_CB_OK;
+}
 
-abort:
-    sr_core_thread_free(result);
-    return DWARF_CB_ABORT;
+/* State shared by the workers of parallel unwinding.  The threads are
+ * listed first and the workers take them one by one, storing the
+ * results to the slot of the thread, which keeps the original order. */
+struct parallel_unwind
+{
+    pid_t *tids;
+    size_t count;
+    size_t next;
+    bool failed;
+    struct sr_core_thread **results;
+    char **errors;
+    pthread_mutex_t lock;
+};
+
+struct unwind_worker
+{
+    struct core_handle *ch;
+    struct parallel_unwind *shared;
+    pthread_t thread;
+};
+
+static int
+collect_tid(Dwfl_Thread *thread, void *data)
+{
+    struct parallel_unwind *shared = data;
+    shared->tids = sr_realloc_array(shared->tids, shared->count + 1,
+                                    sizeof(*shared->tids));
+    shared->tids[shared->count++] = dwfl_thread_tid(thread);
+    return DWARF_CB_OK;
+}
+
+static void *
+unwind_worker_run(void *data)
+{
+    struct unwind_worker *worker = data;
+    struct parallel_unwind *shared = worker->shared;
+
+    while (true)
+    {
+        pthread_mutex_lock(&shared->lock);
+        size_t i = shared->next++;
+        bool stop = shared->failed || i >= shared->count;
+        pthread_mutex_unlock(&shared->lock);
+
+        if (stop)
+            break;
+
+        shared->results[i] = unwind_thread_frames(worker->ch->dwfl,
+                                                  worker->ch->cache, NULL,
+                                                  shared->tids[i],
+                                                  &shared->errors[i]);
+        if (!shared->results[i])
+        {
+            pthread_mutex_lock(&shared->lock);
+            shared->failed = true;
+            pthread_mutex_unlock(&shared->lock);
+        }
+    }
+
+    return NULL;
+}
+
+/* Reduces the list of thread ids to the threads requested by the
+ * options, keeping their order. */
+static void
+select_threads(struct parallel_unwind *shared,
+               const struct sr_core_unwind_options *options,
+               pid_t crash_tid)
+{
+    size_t crash_index = shared->count;
+    for (size_t i = 0; i < shared->count; ++i)
+    {
+        if (shared->tids[i] == crash_tid)
+        {
+            crash_index = i;
+            break;
+        }
+    }
+
+    size_t limit = options->max_threads;
+    if (options->crash_thread_only)
+    {
+        if (crash_index == shared->count)
+        {
+            warn("Crash thread %d not found, unwinding the first thread",
+                 (int)crash_tid);
+            crash_index = 0;
+        }
+
+        limit = 1;
+    }
+
+    if (limit == 0 || limit >= shared->count)
+        return;
+
+    /* Keep the crash thread and fill the rest of the limit with the
+     * first other threads. */
+    size_t others = limit - (crash_index < shared->count ? 1 : 0);
+    size_t count = 0;
+    for (size_t i = 0; i < shared->count; ++i)
+    {
+        if (i == crash_index)
+            shared->tids[count++] = shared->tids[i];
+        else if (others > 0)
+        {
+            shared->tids[count++] = shared->tids[i];
+            --others;
+        }
+    }
+
+    shared->count = count;
+}
+
+/* Unwinds the threads of the coredump opened in ch selected by the
+ * options, using up to options->workers threads.  Stores the threads to
+ * *threads in the order in which libdwfl lists them. */
+static bool
+unwind_thread_list(struct core_handle *ch,
+                   const char *core_file,
+                   const char *exe_file,
+                   const struct sr_core_unwind_options *options,
+                   pid_t crash_tid,
+                   struct sr_core_thread **threads,
+                   char **error_msg)
+{
+    struct parallel_unwind shared = { 0 };
+    pthread_mutex_init(&shared.lock, NULL);
+
+    unsigned nworkers = (options->workers > 1 ? options->workers : 1);
+
+    struct unwind_worker *workers = NULL;
+    unsigned started = 0;
+
+    int ret = dwfl_getthreads(ch->dwfl, collect_tid, &shared);
+    if (ret != 0)
+    {
+        if (ret == -1)
+            set_error_dwfl("dwfl_getthreads");
+        else
+            set_error("Unknown error in dwfl_getthreads");
+        shared.failed = true;
+        goto out;
+    }
+
+    select_threads(&shared, options, crash_tid);
+    if (shared.count == 0)
+        goto out;
+
+    if (nworkers > shared.count)
+        nworkers = shared.count;
+
+    shared.results = sr_mallocz(shared.count * sizeof(*shared.results));
+    shared.errors = sr_mallocz(shared.count * sizeof(*shared.errors));
+    workers = sr_mallocz(nworkers * sizeof(*workers));
+
+    /* libdwfl handles must not be shared between threads, every worker
+     * gets its own.  They are opened here, before any unwinding starts,
+     * because opening reports the modules through find_elf_core(). */
+    for (unsigned i = 0; i < nworkers; ++i)
+    {
+        workers[i].shared = &shared;
+        if (i == 0)
+        {
+            workers[i].ch = ch;
+            continue;
+        }
+
+        char *open_error = NULL;
+        workers[i].ch = open_coredump(core_file, exe_file, &open_error);
+        if (workers[i].ch && dwfl_core_file_attach(workers[i].ch->dwfl,
+                                                   workers[i].ch->eh) < 0)
+        {
+            core_handle_free(workers[i].ch);
+            workers[i].ch = NULL;
+        }
+
+        if (!workers[i].ch)
+        {
+            /* Continue with the workers we have. */
+            warn("Failed to open coredump for unwinding worker: %s",
+                 open_error ? open_error : dwfl_errmsg(-1));
+            free(open_error);
+            nworkers = i;
+            break;
+        }
+    }
+
+    for (started = 0; nworkers > 1 && started < nworkers; ++started)
+    {
+        if (pthread_create(&workers[started].thread, NULL,
+                           unwind_worker_run, &workers[started]) != 0)
+        {
+            break;
+        }
+    }
+
+    /* Unwind in the calling thread if there is just one worker, or if
+     * no worker could be started. */
+    if (started == 0)
+    {
+        struct unwind_worker self = { .ch = ch, .shared = &shared };
+        unwind_worker_run(&self);
+    }
+
+    for (unsigned i = 0; i < started; ++i)
+        pthread_join(workers[i].thread, NULL);
+
+    shared.failed = !unwound_threads_merge(shared.results, shared.errors,
+                                           shared.count, threads, error_msg);
+
+    for (size_t i = 0; i < shared.count; ++i)
+        free(shared.errors[i]);
+
+out:
+    for (unsigned i = 1; workers && i < nworkers; ++i)
+        core_handle_free(workers[i].ch);
+
+    free(workers);
+    free(shared.results);
+    free(shared.errors);
+    free(shared.tids);
+    pthread_mutex_destroy(&shared.lock);
+    return !shared.failed;
 }
 
 struct sr_core_stacktrace *
 sr_parse_coredump(const char *core_file,
                   const char *exe_file,
                   char **error_msg)
+{
+    return sr_parse_coredump_ex(core_file, exe_file, NULL, error_msg);
+}
+
+struct sr_core_stacktrace *
+sr_parse_coredump_ex(const char *core_file,
+                     const char *exe_file,
+                     const struct sr_core_unwind_options *options,
+                     char **error_msg)
 {
     struct sr_core_stacktrace *stacktrace = NULL;
+    const struct sr_core_unwind_options no_options = { 0 };
+    if (!options)
+        options = &no_options;
 
     /* Initialize error_msg to 'no error'. */
     if (error_msg)
@@ -178,34 +439,64 @@ sr_parse_coredump(const char *core_file,
         goto fail;
     }
 
-    struct thread_callback_arg thread_arg =
-    {
-        .threads_tail = &(stacktrace->threads),
-        .error_msg = NULL
-    };
+    pid_t crash_tid = 0;
+    stacktrace->signal = get_signal_and_tid(ch->eh, core_file, &crash_tid);
 
-    int ret = dwfl_getthreads(ch->dwfl, unwind_thread, &thread_arg);
-    if (ret != 0)
+    if (options->workers > 1 || options->crash_thread_only
+        || options->max_threads > 0)
     {
-        if (ret == -1)
-            set_error_dwfl("dwfl_getthreads");
-        else if (ret == DWARF_CB_ABORT)
+        if (!unwind_thread_list(ch, core_file, exe_file, options, crash_tid,
+                                &stacktrace->threads, error_msg))
         {
-            set_error("%s", thread_arg.error_msg);
-            free(thread_arg.error_msg);
+            sr_core_stacktrace_free(stacktrace);
+            stacktrace = NULL;
+            goto fail;
         }
-        else
-            set_error("Unknown error in dwfl_getthreads");
+    }
+    else
+    {
+        struct thread_callback_arg thread_arg =
+        {
+            .threads_tail = &(stacktrace->threads),
+            .error_msg = NULL,
+            .cache = ch->cache
+        };
 
-        sr_core_stacktrace_free(stacktrace);
-        stacktrace = NULL;
-        goto fail;
+        int ret = dwfl_getthreads(ch->dwfl, unwind_thread, &thread_arg);
+        if (ret != 0)
+        {
+            if (ret == -1)
+                set_error_dwfl("dwfl_getthreads");
+            else if (ret == DWARF_CB_ABORT)
+            {
+                set_error("%s", thread_arg.error_msg);
+                free(thread_arg.error_msg);
+            }
+            else
+                set_error("Unknown error in dwfl_getthreads");
+
+            sr_core_stacktrace_free(stacktrace);
+            stacktrace = NULL;
+            goto fail;
+        }
     }
 
     stacktrace->executable = sr_strdup(exe_file);
-    stacktrace->signal = get_signal_number(ch->eh, core_file);
-    /* FIXME: is this the best we can do? */
+    stacktrace->only_crash_thread = options->crash_thread_only;
+
+    /* The thread that received the signal has crashed.  Assume the first
+     * thread if the coredump does not tell. */
     stacktrace->crash_thread = stacktrace->threads;
+    for (struct sr_core_thread *thread = stacktrace->threads;
+         thread && crash_tid;
+         thread = thread->next)
+    {
+        if (thread->id == crash_tid)
+        {
+            stacktrace->crash_thread = thread;
+            break;
+        }
+    }
 
 fail:
     core_handle_free(ch);
@@ -21,6 +21,7 @@
 #include "core/frame.h"
 #include "core/thread.h"
 #include "core/stacktrace.h"
+#include "core/unwind.h"
 #include "internal_unwind.h"
 #include "internal_utils.h"
 
@@ -32,7 +33,7 @@
 static struct sr_core_thread *
 unwind_thread(struct UCD_info *ui,
               unw_addr_space_t as,
-              Dwfl *dwfl,
+              struct core_handle *ch,
               int thread_no,
               char **error_msg)
 {
@@ -62,7 +63,7 @@ unwind_thread(struct UCD_info *ui,
         if (ip == 0)
             break;
 
-        struct sr_core_frame *entry = resolve_frame(dwfl, ip, false);
+        struct sr_core_frame *entry = resolve_frame(ch->dwfl, ip, false, ch->cache);
 
         if (!entry->function_name)
         {
@@ -178,7 +179,7 @@ sr_parse_coredump(const char *core_file,
     int tnum, nthreads = _UCD_get_num_threads(ui);
     for (tnum = 0; tnum < nthreads; ++tnum)
     {
-        struct sr_core_thread *trace = unwind_thread(ui, as, ch->dwfl, tnum, error_msg);
+        struct sr_core_thread *trace = unwind_thread(ui, as, ch, tnum, error_msg);
         if (trace)
         {
             stacktrace->threads = sr_core_thread_append(stacktrace->threads, trace);
@@ -205,4 +206,22 @@ fail_destroy_handle:
     return stacktrace;
 }
 
+struct sr_core_stacktrace *
+sr_parse_coredump_ex(const char *core_file,
+                     const char *exe_file,
+                     const struct sr_core_unwind_options *options,
+                     char **error_msg)
+{
+    /* The threads are always unwound one by one, which gives the same
+     * result as any number of workers, but they cannot be selected. */
+    if (options && (options->crash_thread_only || options->max_threads > 0))
+    {
+        set_error("Thread selection is not supported by the libunwind "
+                  "unwinder");
+        return NULL;
+    }
+
+    return sr_parse_coredump(core_file, exe_file, error_msg);
+}
+
 #endif /* WITH_LIBUNWIND */
@@ -18,9 +18,11 @@
     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
 #include "elves.h"
+#include "hash_table.h"
 #include "utils.h"
 #include "config.h"
 #include "strbuf.h"
+#include <pthread.h>
 
 #if (defined HAVE_DWARF_H && defined HAVE_ELFUTILS_LIBDW_H && defined HAVE_LIBELF_H && defined HAVE_GELF_H && defined HAVE_LIBELF)
 #  define WITH_ELFUTILS
@@ -132,7 +134,7 @@ sr_elf_get_procedure_linkage_table(const char *filename,
     }
 
     /* Initialize libelf on the opened file. */
-    Elf *elf = elf_begin(fd, ELF_C_READ, NULL);
+    Elf *elf = elf_begin(fd, ELF_C_READ_MMAP, NULL);
     if (!elf)
     {
         *error_message = sr_asprintf("Failed to run elf_begin on file %s: %s",
@@ -357,6 +359,38 @@ sr_elf_plt_find_for_address(struct sr_elf_plt_entry *plt,
 }
 
 
+struct elf_cie *
+elf_cie_table_append(struct elf_cie_table *table)
+{
+    if (table->count == table->allocated)
+    {
+        table->allocated = (table->allocated ? 2 * table->allocated : 16);
+        table->entries = sr_realloc_array(table->entries, table->allocated,
+                                          sizeof(*table->entries));
+    }
+
+    return &table->entries[table->count++];
+}
+
+struct elf_cie *
+elf_cie_table_find(const struct elf_cie_table *table, uint64_t cie_offset)
+{
+    size_t low = 0, high = table->count;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (table->entries[middle].cie_offset < cie_offset)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if (low < table->count && table->entries[low].cie_offset == cie_offset)
+        return &table->entries[low];
+
+    return NULL;
+}
+
 #ifdef WITH_ELFUTILS
 /* Given DWARF pointer encoding, return the length of the pointer in
  * bytes.
@@ -379,39 +413,19 @@ encoded_size(const uint8_t encoding, const unsigned char *e_ident)
     }
 }
 
-struct cie
-{
-    Dwarf_Off cie_offset;
-    int ptr_len;
-    bool pcrel;
-
-    struct cie *next;
-};
-
-static void
-cie_free(struct cie *entries)
-{
-    while (entries)
-    {
-        struct cie *entry = entries;
-        entries = entry->next;
-        free(entry);
-    }
-}
-
-
-static struct cie *
+static bool
 read_cie(Dwarf_CFI_Entry *cfi,
          Dwarf_Off cfi_offset,
          unsigned char *e_ident,
+         struct elf_cie *cie,
          char **error_message)
 {
     /* Default FDE encoding (i.e. no R in augmentation string) is
      * DW_EH_PE_absptr.
      */
-    struct cie *cie = sr_mallocz(sizeof(struct cie));
     cie->cie_offset = cfi_offset;
     cie->ptr_len = encoded_size(DW_EH_PE_absptr, e_ident);
+    cie->pcrel = false;
 
     /* Search the augmentation data for FDE pointer encoding.
      * Unfortunately, 'P' can come before 'R' (which we are looking
@@ -433,14 +447,13 @@ read_cie(Dwarf_CFI_Entry *cfi,
             {
                 *error_message = sr_asprintf("Unknown FDE encoding (CIE %jx)",
                                              (uintmax_t)cfi_offset);
-                free(cie);
-                return NULL;
+                return false;
             }
 
             if ((*augmentation_data & 0x70) == DW_EH_PE_pcrel)
                 cie->pcrel = true;
 
-            return cie;
+            return true;
         case 'L':
             ++augmentation_data;
             break;
@@ -451,9 +464,7 @@ read_cie(Dwarf_CFI_Entry *cfi,
             {
                 *error_message = sr_asprintf("Unknown size for personality encoding (CIE %jx)",
                                              (uintmax_t)cfi_offset);
-
-                free(cie);
-                return NULL;
+                return false;
             }
 
             augmentation_data += size + 1;
@@ -462,14 +473,13 @@ read_cie(Dwarf_CFI_Entry *cfi,
         default:
             *error_message = sr_asprintf("Unknown augmentation char (CIE %jx)",
                                          (uintmax_t)cfi_offset);
-            free(cie);
-            return NULL;
+            return false;
         }
 
         ++augmentation;
     }
 
-    return cie;
+    return true;
 }
 
 /* Read len bytes and interpret them as a number. Pointer p does not
@@ -481,21 +491,110 @@ read_cie(Dwarf_CFI_Entry *cfi,
 static uint64_t
 fde_read_address(const uint8_t *p, unsigned len)
 {
-    int i;
-    union {
-        uint8_t b[8];
-        /* uint16_t n2; */
+    if (len == 4)
+    {
         uint32_t n4;
-        uint64_t n8;
-    } u;
+        memcpy(&n4, p, sizeof(n4));
+        return n4;
+    }
 
-    for (i = 0; i < len; i++)
-        u.b[i] = *p++;
+    uint64_t n8;
+    memcpy(&n8, p, sizeof(n8));
+    return n8;
+}
+#endif /* WITH_ELFUTILS */
+
+/* The lists read by sr_elf_get_eh_frame(), mapped to their indices.  The
+ * index of a list is built on its first lookup, so that the lookups by
+ * sr_elf_find_fde_for_*() search in O(log n) without callers building
+ * an index themselves.  Lists built elsewhere are searched linearly. */
+static struct
+{
+    pthread_mutex_t lock;
+    /* struct sr_elf_fde * -> struct sr_elf_fde_index * or NULL */
+    struct hash_table *indices;
+} eh_frames = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static size_t
+hash_pointer(const void *key)
+{
+    return hash_bytes(&key, sizeof(key));
+}
+
+static bool
+pointer_equal(const void *key1, const void *key2)
+{
+    return key1 == key2;
+}
+
+static void
+index_free(void *index)
+{
+    sr_elf_fde_index_free(index);
+}
+
+#ifdef WITH_ELFUTILS
+static void
+eh_frame_register(struct sr_elf_fde *eh_frame)
+{
+    if (!eh_frame)
+        return;
 
-    return (len == 4 ? (uint64_t)u.n4 : u.n8);
+    pthread_mutex_lock(&eh_frames.lock);
+    if (!eh_frames.indices)
+    {
+        eh_frames.indices = hash_table_new(hash_pointer, pointer_equal,
+                                           NULL, index_free);
+    }
+
+    hash_table_insert(eh_frames.indices, eh_frame, NULL);
+    pthread_mutex_unlock(&eh_frames.lock);
 }
 #endif /* WITH_ELFUTILS */
 
+static void
+eh_frame_unregister(struct sr_elf_fde *eh_frame)
+{
+    pthread_mutex_lock(&eh_frames.lock);
+    if (eh_frames.indices)
+        hash_table_remove(eh_frames.indices, eh_frame);
+
+    pthread_mutex_unlock(&eh_frames.lock);
+}
+
+/* Returns the index of a list read by sr_elf_get_eh_frame(), or NULL for
+ * other lists.  The index lives as long as the list. */
+static const struct sr_elf_fde_index *
+eh_frame_index(struct sr_elf_fde *eh_frame)
+{
+    void *index = NULL;
+    pthread_mutex_lock(&eh_frames.lock);
+    bool registered = (eh_frames.indices
+                       && hash_table_lookup(eh_frames.indices, eh_frame,
+                                            &index));
+    pthread_mutex_unlock(&eh_frames.lock);
+
+    if (!registered || index)
+        return index;
+
+    /* Sort without holding the lock, other threads may have built the
+     * index meanwhile. */
+    struct sr_elf_fde_index *built = sr_elf_fde_index_new(eh_frame);
+    pthread_mutex_lock(&eh_frames.lock);
+    if (hash_table_lookup(eh_frames.indices, eh_frame, &index) && !index)
+    {
+        hash_table_insert(eh_frames.indices, eh_frame, built);
+        index = built;
+        built = NULL;
+    }
+
+    pthread_mutex_unlock(&eh_frames.lock);
+    sr_elf_fde_index_free(built);
+    return index;
+}
+
 struct sr_elf_fde *
 sr_elf_get_eh_frame(const char *filename,
                     char **error_message)
@@ -512,7 +611,7 @@ sr_elf_get_eh_frame(const char *filename,
     }
 
     /* Initialize libelf on the opened file. */
-    Elf *elf = elf_begin(fd, ELF_C_READ, NULL);
+    Elf *elf = elf_begin(fd, ELF_C_READ_MMAP, NULL);
     if (!elf)
     {
         *error_message = sr_asprintf("Failed to run elf_begin on file %s: %s",
@@ -616,7 +715,7 @@ sr_elf_get_eh_frame(const char *filename,
      */
 
     struct sr_elf_fde *result = NULL, *last = NULL;
-    struct cie *cie_list = NULL, *cie_list_last = NULL;
+    struct elf_cie_table cies = { NULL, 0, 0 };
 
     Dwarf_Off cfi_offset_next = 0;
     while (true)
@@ -647,7 +746,7 @@ sr_elf_get_eh_frame(const char *filename,
                                          filename,
                                          dwarf_errmsg(-1));
 
-            cie_free(cie_list);
+            free(cies.entries);
             sr_elf_eh_frame_free(result);
             elf_end(elf);
             close(fd);
@@ -664,57 +763,41 @@ sr_elf_get_eh_frame(const char *filename,
              * DW_EH_PE_absptr.
              */
             char *cie_error_message;
-            struct cie *cie = read_cie(&cfi,
-                                       cfi_offset,
-                                       e_ident,
-                                       &cie_error_message);
-            if (!cie)
+            if (!read_cie(&cfi,
+                          cfi_offset,
+                          e_ident,
+                          elf_cie_table_append(&cies),
+                          &cie_error_message))
             {
                 *error_message = sr_asprintf("CIE reading failed for %s: %s",
                                              filename,
                                              cie_error_message);
 
                 free(cie_error_message);
-                cie_free(cie_list);
+                free(cies.entries);
                 sr_elf_eh_frame_free(result);
                 elf_end(elf);
                 close(fd);
                 return NULL;
             }
-
-            /* Append the newly parsed CIE to our list of CIEs. */
-            if (cie_list)
-            {
-                cie_list_last->next = cie;
-                cie_list_last = cie;
-            }
-            else
-                cie_list = cie_list_last = cie;
         }
         else
         {
             /* Current CFI is an FDE.
              */
-            struct cie *cie = cie_list;
-
-            /* Find the CIE data that we should have saved earlier. */
-            while (cie)
-            {
-                /* In .eh_frame, CIE_pointer is relative, but libdw converts it
-                 * to absolute offset. */
-                if (cfi.fde.CIE_pointer == cie->cie_offset)
-                    break; /* Found. */
-
-                cie = cie->next;
-            }
 
+            /* Find the CIE data that we should have saved earlier.  In
+             * .eh_frame, CIE_pointer is relative, but libdw converts it
+             * to absolute offset. */
+            struct elf_cie *cie = elf_cie_table_find(&cies,
+                                                     cfi.fde.CIE_pointer);
             if (!cie)
             {
                 *error_message = sr_asprintf("CIE not found for FDE %jx in %s",
                                              (uintmax_t)cfi_offset,
                                              filename);
 
-                cie_free(cie_list);
+                free(cies.entries);
                 sr_elf_eh_frame_free(result);
                 elf_end(elf);
                 close(fd);
@@ -770,9 +853,10 @@ sr_elf_get_eh_frame(const char *filename,
         }
     }
 
-    cie_free(cie_list);
+    free(cies.entries);
     elf_end(elf);
     close(fd);
+    eh_frame_register(result);
     return result;
 #else /* WITH_ELFUTILS */
     *error_message = sr_asprintf("satyr compiled without elfutils");
@@ -783,6 +867,11 @@ sr_elf_get_eh_frame(const char *filename,
 void
 sr_elf_eh_frame_free(struct sr_elf_fde *entries)
 {
+    /* Before the entries are freed, so that a list allocated at the same
+     * address is not mistaken for this one. */
+    if (entries)
+        eh_frame_unregister(entries);
+
     while (entries)
     {
         struct sr_elf_fde *entry = entries;
@@ -795,6 +884,10 @@ struct sr_elf_fde *
 sr_elf_find_fde_for_offset(struct sr_elf_fde *eh_frame,
                            uint64_t build_id_offset)
 {
+    const struct sr_elf_fde_index *index = eh_frame_index(eh_frame);
+    if (index)
+        return sr_elf_fde_index_find_offset(index, build_id_offset);
+
     struct sr_elf_fde *fde = eh_frame;
     while (fde)
     {
@@ -814,6 +907,10 @@ struct sr_elf_fde *
 sr_elf_find_fde_for_address(struct sr_elf_fde *eh_frame,
                             uint64_t address)
 {
+    const struct sr_elf_fde_index *index = eh_frame_index(eh_frame);
+    if (index)
+        return sr_elf_fde_index_find_address(index, address);
+
     struct sr_elf_fde *fde = eh_frame;
     while (fde)
     {
@@ -833,6 +930,10 @@ struct sr_elf_fde *
 sr_elf_find_fde_for_start_address(struct sr_elf_fde *eh_frame,
                                   uint64_t start_address)
 {
+    const struct sr_elf_fde_index *index = eh_frame_index(eh_frame);
+    if (index)
+        return sr_elf_fde_index_find_start_address(index, start_address);
+
     struct sr_elf_fde *fde = eh_frame;
     while (fde)
     {
@@ -845,6 +946,169 @@ sr_elf_find_fde_for_start_address(struct sr_elf_fde *eh_frame,
     return NULL;
 }
 
+struct fde_index_entry
+{
+    /* Key the entries are sorted by: the start address relative to the
+     * beginning of the file for the offset lookups, or the absolute one
+     * for the address lookups. */
+    uint64_t start;
+    uint64_t end;
+    /* Maximum of end over this and all the preceding entries, so that
+     * a search can stop walking back once no earlier range can reach
+     * the searched value.  FDEs do not overlap in practice, so the walk
+     * ends right away. */
+    uint64_t max_end;
+    /* Position in the list, the first entry in the list order wins. */
+    size_t position;
+    struct sr_elf_fde *fde;
+};
+
+struct sr_elf_fde_index
+{
+    /* Entries sorted by relative and by absolute start address.  Each
+     * FDE carries its own exec_base, so the two orders may differ. */
+    struct fde_index_entry *by_offset;
+    struct fde_index_entry *by_address;
+    size_t count;
+};
+
+static int
+fde_index_entry_cmp(const void *a, const void *b)
+{
+    const struct fde_index_entry *e1 = a, *e2 = b;
+    if (e1->start != e2->start)
+        return (e1->start < e2->start ? -1 : 1);
+
+    return (e1->position < e2->position ? -1 : 1);
+}
+
+static struct fde_index_entry *
+fde_index_build(struct sr_elf_fde *eh_frame, size_t count, bool absolute)
+{
+    struct fde_index_entry *entries = sr_malloc_array(count ? count : 1,
+                                                      sizeof(*entries));
+    size_t i = 0;
+    for (struct sr_elf_fde *fde = eh_frame; fde; fde = fde->next, ++i)
+    {
+        entries[i].start = fde->start_address + (absolute ? fde->exec_base : 0);
+        entries[i].end = entries[i].start + fde->length;
+        entries[i].position = i;
+        entries[i].fde = fde;
+    }
+
+    qsort(entries, count, sizeof(*entries), fde_index_entry_cmp);
+
+    uint64_t max_end = 0;
+    for (i = 0; i < count; ++i)
+    {
+        if (entries[i].end > max_end)
+            max_end = entries[i].end;
+
+        entries[i].max_end = max_end;
+    }
+
+    return entries;
+}
+
+struct sr_elf_fde_index *
+sr_elf_fde_index_new(struct sr_elf_fde *eh_frame)
+{
+    struct sr_elf_fde_index *index = sr_malloc(sizeof(*index));
+    index->count = 0;
+    for (struct sr_elf_fde *fde = eh_frame; fde; fde = fde->next)
+        ++index->count;
+
+    index->by_offset = fde_index_build(eh_frame, index->count, false);
+    index->by_address = fde_index_build(eh_frame, index->count, true);
+    return index;
+}
+
+void
+sr_elf_fde_index_free(struct sr_elf_fde_index *index)
+{
+    if (!index)
+        return;
+
+    free(index->by_offset);
+    free(index->by_address);
+    free(index);
+}
+
+/* Returns the number of entries with start <= value. */
+static size_t
+fde_index_upper_bound(const struct fde_index_entry *entries, size_t count,
+                      uint64_t value)
+{
+    size_t low = 0, high = count;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (entries[middle].start <= value)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+static struct sr_elf_fde *
+fde_index_find_containing(const struct fde_index_entry *entries, size_t count,
+                          uint64_t value)
+{
+    const struct fde_index_entry *found = NULL;
+    size_t i = fde_index_upper_bound(entries, count, value);
+    while (i > 0 && entries[i - 1].max_end > value)
+    {
+        --i;
+        if (value < entries[i].end
+            && (!found || entries[i].position < found->position))
+        {
+            found = &entries[i];
+        }
+    }
+
+    return (found ? found->fde : NULL);
+}
+
+struct sr_elf_fde *
+sr_elf_fde_index_find_offset(const struct sr_elf_fde_index *index,
+                             uint64_t build_id_offset)
+{
+    return fde_index_find_containing(index->by_offset, index->count,
+                                     build_id_offset);
+}
+
+struct sr_elf_fde *
+sr_elf_fde_index_find_address(const struct sr_elf_fde_index *index,
+                              uint64_t address)
+{
+    return fde_index_find_containing(index->by_address, index->count,
+                                     address);
+}
+
+struct sr_elf_fde *
+sr_elf_fde_index_find_start_address(const struct sr_elf_fde_index *index,
+                                    uint64_t start_address)
+{
+    /* The first entry with start >= start_address, which is the first
+     * one in the list order among equal starts. */
+    size_t low = 0, high = index->count;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (index->by_address[middle].start < start_address)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if (low < index->count && index->by_address[low].start == start_address)
+        return index->by_address[low].fde;
+
+    return NULL;
+}
+
 char *
 sr_elf_fde_to_json(struct sr_elf_fde *fde,
                    bool recursive)
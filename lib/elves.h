@@ -34,6 +34,7 @@ extern "C" {
 
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * @brief A single item of the Procedure Linkage Table present in ELF
@@ -103,7 +104,10 @@ sr_elf_plt_find_for_address(struct sr_elf_plt_entry *plt,
  *   function.
  * @returns
  *   Returns a linked list of function ranges (function offset and
- *   size) on success. Otherwise NULL.
+ *   size) on success. Otherwise NULL.  The list must be released by
+ *   sr_elf_eh_frame_free() and must not be modified; the
+ *   sr_elf_find_fde_for_*() functions search it in O(log n) using an
+ *   index built on the first lookup.
  */
 struct sr_elf_fde *
 sr_elf_get_eh_frame(const char *filename,
@@ -124,10 +128,69 @@ struct sr_elf_fde *
 sr_elf_find_fde_for_start_address(struct sr_elf_fde *eh_frame,
                                   uint64_t start_address);
 
+/**
+ * @brief Sorted array of the FDEs of a list, searched in O(log n).
+ *
+ * The index refers to the entries of the list it has been built from,
+ * the list must outlive the index and must not be modified meanwhile.
+ * The lookups return the same entry as the corresponding
+ * sr_elf_find_fde_for_*() functions on the list.
+ */
+struct sr_elf_fde_index;
+
+/**
+ * Builds the index of an FDE list.  Lists returned by
+ * sr_elf_get_eh_frame() are indexed by the find functions already.
+ * Never returns NULL; an empty list gives an empty index.
+ */
+struct sr_elf_fde_index *
+sr_elf_fde_index_new(struct sr_elf_fde *eh_frame);
+
+void
+sr_elf_fde_index_free(struct sr_elf_fde_index *index);
+
+struct sr_elf_fde *
+sr_elf_fde_index_find_offset(const struct sr_elf_fde_index *index,
+                             uint64_t build_id_offset);
+
+struct sr_elf_fde *
+sr_elf_fde_index_find_address(const struct sr_elf_fde_index *index,
+                              uint64_t address);
+
+struct sr_elf_fde *
+sr_elf_fde_index_find_start_address(const struct sr_elf_fde_index *index,
+                                    uint64_t start_address);
+
 char *
 sr_elf_fde_to_json(struct sr_elf_fde *fde,
                    bool recursive);
 
+/* The CIEs read by sr_elf_get_eh_frame(), declared here for the tests.
+ * Without the sr_ prefix, the functions are not exported. */
+struct elf_cie
+{
+    uint64_t cie_offset;
+    int ptr_len;
+    bool pcrel;
+};
+
+/* CIEs of a section, in the order of their offsets as they are read
+ * sequentially. */
+struct elf_cie_table
+{
+    struct elf_cie *entries;
+    size_t count;
+    size_t allocated;
+};
+
+/* Returns the new last entry, to be filled by the caller. */
+struct elf_cie *
+elf_cie_table_append(struct elf_cie_table *table);
+
+/* Returns NULL if there is no CIE at the offset. */
+struct elf_cie *
+elf_cie_table_find(const struct elf_cie_table *table, uint64_t cie_offset);
+
 #ifdef __cplusplus
 }
 #endif
@@ -307,16 +307,19 @@ findfirstabnul(const char *input,
 {
     size_t alen = strlen(a);
     size_t blen = strlen(b);
+    const char first[] = { a[0], b[0], '\0' };
     const char *p = input;
-    while (*p)
+    /* Jump between the possible starts of a or b, and update the
+     * location only once when the search is finished. */
+    while (*(p += strcspn(p, first)))
     {
         if (strncmp(p, a, alen) == 0)
-            return p;
+            break;
         if (strncmp(p, b, blen) == 0)
-            return p;
-        sr_location_eat_char(location, *p);
+            break;
         ++p;
     }
+    sr_location_eat_chars(location, input, p - input);
     return p;
 }
 
@@ -812,6 +815,7 @@ sr_gdb_frame_skip_function_args(const char **input,
     }
     location->column += 1;
 
+    const char *args = local_input;
     int depth = 0;
     bool string = false;
     bool escape = false;
@@ -851,11 +855,12 @@ sr_gdb_frame_skip_function_args(const char **input,
                     break;
             }
         }
-        sr_location_eat_char(location, *local_input);
         ++local_input;
     }
     while (*local_input);
 
+    sr_location_eat_chars(location, args, local_input - args);
+
     if (depth != 0 || string || escape)
     {
         location->message = "Unbalanced function parameter list.";
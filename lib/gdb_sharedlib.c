@@ -120,6 +120,112 @@ sr_gdb_sharedlib_find_address(struct sr_gdb_sharedlib *first,
     return NULL;
 }
 
+struct index_entry
+{
+    uint64_t from;
+    uint64_t to;
+    /* Maximum of 'to' over this and all the preceding entries.  Ranges
+     * do not overlap in practice, so the search hardly ever walks back
+     * more than one entry. */
+    uint64_t max_to;
+    /* Position in the list, the first sharedlib in the list order wins,
+     * as in sr_gdb_sharedlib_find_address(). */
+    size_t position;
+    struct sr_gdb_sharedlib *sharedlib;
+};
+
+struct sr_gdb_sharedlib_index
+{
+    /* Sorted by 'from'. */
+    struct index_entry *entries;
+    size_t count;
+};
+
+static int
+index_entry_cmp(const void *a, const void *b)
+{
+    const struct index_entry *e1 = a, *e2 = b;
+    if (e1->from != e2->from)
+        return (e1->from < e2->from ? -1 : 1);
+
+    return (e1->position < e2->position ? -1 : 1);
+}
+
+struct sr_gdb_sharedlib_index *
+sr_gdb_sharedlib_index_new(struct sr_gdb_sharedlib *first)
+{
+    struct sr_gdb_sharedlib_index *index = sr_malloc(sizeof(*index));
+    index->count = sr_gdb_sharedlib_count(first);
+    index->entries = sr_malloc_array(index->count ? index->count : 1,
+                                     sizeof(*index->entries));
+
+    size_t i = 0;
+    for (struct sr_gdb_sharedlib *lib = first; lib; lib = lib->next, ++i)
+    {
+        index->entries[i].from = lib->from;
+        index->entries[i].to = lib->to;
+        index->entries[i].position = i;
+        index->entries[i].sharedlib = lib;
+    }
+
+    qsort(index->entries, index->count, sizeof(*index->entries),
+          index_entry_cmp);
+
+    uint64_t max_to = 0;
+    for (i = 0; i < index->count; ++i)
+    {
+        if (index->entries[i].to > max_to)
+            max_to = index->entries[i].to;
+
+        index->entries[i].max_to = max_to;
+    }
+
+    return index;
+}
+
+void
+sr_gdb_sharedlib_index_free(struct sr_gdb_sharedlib_index *index)
+{
+    if (!index)
+        return;
+
+    free(index->entries);
+    free(index);
+}
+
+struct sr_gdb_sharedlib *
+sr_gdb_sharedlib_index_find_address(const struct sr_gdb_sharedlib_index *index,
+                                    uint64_t address)
+{
+    if (address == -1)
+        return NULL;
+
+    /* Number of entries with from <= address. */
+    size_t low = 0, high = index->count;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (index->entries[middle].from <= address)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    const struct index_entry *found = NULL;
+    while (low > 0 && index->entries[low - 1].max_to >= address)
+    {
+        --low;
+        const struct index_entry *entry = &index->entries[low];
+        if (address <= entry->to
+            && (!found || entry->position < found->position))
+        {
+            found = entry;
+        }
+    }
+
+    return (found ? found->sharedlib : NULL);
+}
+
 static char *
 find_sharedlib_section_start(const char *input)
 {
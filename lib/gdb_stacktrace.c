@@ -446,7 +446,6 @@ sr_gdb_stacktrace_parse(const char **input,
     const char *local_input = *input;
     /* im - intermediate */
     struct sr_gdb_stacktrace *imstacktrace = sr_gdb_stacktrace_new();
-    imstacktrace->libs = sr_gdb_sharedlib_parse(*input);
 
     /* The header is mandatory, but it might contain no frame header,
      * in some broken stacktraces. In that case, stacktrace.crash value
@@ -460,6 +459,8 @@ sr_gdb_stacktrace_parse(const char **input,
         return NULL;
     }
 
+    const char *header_end = local_input, *last_thread = local_input;
+    const char *thread_start = local_input;
     struct sr_gdb_thread *thread, *prevthread = NULL;
     while ((thread = sr_gdb_thread_parse(&local_input, location)))
     {
@@ -470,6 +471,9 @@ sr_gdb_stacktrace_parse(const char **input,
         }
         else
             imstacktrace->threads = prevthread = thread;
+
+        last_thread = thread_start;
+        thread_start = local_input;
     }
     if (!imstacktrace->threads)
     {
@@ -477,6 +481,20 @@ sr_gdb_stacktrace_parse(const char **input,
         return NULL;
     }
 
+    /* GDB prints the shared library table after the threads, where the
+     * variables section of the last frame extends over it.  Search the
+     * text of the last thread, so that the input is not scanned once
+     * more from the beginning.  Otherwise the table can only be in the
+     * header before the first thread.
+     */
+    imstacktrace->libs = sr_gdb_sharedlib_parse(last_thread);
+    if (!imstacktrace->libs && header_end > *input)
+    {
+        char *header = sr_strndup(*input, header_end - *input);
+        imstacktrace->libs = sr_gdb_sharedlib_parse(header);
+        free(header);
+    }
+
     *input = local_input;
     return imstacktrace;
 }
@@ -564,12 +582,17 @@ sr_gdb_stacktrace_parse_header(const char **input,
 void
 sr_gdb_stacktrace_set_libnames(struct sr_gdb_stacktrace *stacktrace)
 {
+    struct sr_gdb_sharedlib_index *index =
+        sr_gdb_sharedlib_index_new(stacktrace->libs);
+
     struct sr_gdb_thread *thread = stacktrace->threads;
     while (thread)
     {
-        sr_gdb_thread_set_libnames(thread, stacktrace->libs);
+        sr_gdb_thread_set_libnames_indexed(thread, index);
         thread = thread->next;
     }
+
+    sr_gdb_sharedlib_index_free(index);
 }
 
 char *
@@ -522,34 +522,55 @@ sr_gdb_thread_format_funs(struct sr_gdb_thread *thread)
     return sr_strbuf_free_nobuf(buf);
 }
 
+static void
+set_library_name(struct sr_gdb_frame *frame, struct sr_gdb_sharedlib *lib)
+{
+    char *s1, *s2;
+
+    /* Strip directory and version after the .so suffix. */
+    s1 = strrchr(lib->soname, '/');
+    if (!s1)
+        s1 = lib->soname;
+    else
+        s1++;
+    s2 = strstr(s1, ".so");
+    if (!s2)
+        s2 = s1 + strlen(s1);
+    else
+        s2 += strlen(".so");
+
+    if (frame->library_name)
+        free(frame->library_name);
+    frame->library_name = sr_strndup(s1, s2 - s1);
+}
+
 void
 sr_gdb_thread_set_libnames(struct sr_gdb_thread *thread, struct sr_gdb_sharedlib *libs)
 {
+    /* A single thread does not pay off building an index, callers
+     * handling many threads use sr_gdb_thread_set_libnames_indexed(). */
     struct sr_gdb_frame *frame = thread->frames;
     while (frame)
     {
         struct sr_gdb_sharedlib *lib = sr_gdb_sharedlib_find_address(libs,
                                                                      frame->address);
         if (lib)
-        {
-            char *s1, *s2;
-
-            /* Strip directory and version after the .so suffix. */
-            s1 = strrchr(lib->soname, '/');
-            if (!s1)
-                s1 = lib->soname;
-            else
-                s1++;
-            s2 = strstr(s1, ".so");
-            if (!s2)
-                s2 = s1 + strlen(s1);
-            else
-                s2 += strlen(".so");
+            set_library_name(frame, lib);
+        frame = frame->next;
+    }
+}
 
-            if (frame->library_name)
-                free(frame->library_name);
-            frame->library_name = sr_strndup(s1, s2 - s1);
-        }
+void
+sr_gdb_thread_set_libnames_indexed(struct sr_gdb_thread *thread,
+                                   const struct sr_gdb_sharedlib_index *index)
+{
+    struct sr_gdb_frame *frame = thread->frames;
+    while (frame)
+    {
+        struct sr_gdb_sharedlib *lib =
+            sr_gdb_sharedlib_index_find_address(index, frame->address);
+        if (lib)
+            set_library_name(frame, lib);
         frame = frame->next;
     }
 }
@@ -19,6 +19,7 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "internal_utils.h"
 #include "strbuf.h"
@@ -100,6 +101,25 @@ sr_stacktrace_parse(enum sr_report_type type, const char *input, char **error_me
     return DISPATCH(dtable, type, parse)(input, error_message);
 }
 
+struct sr_stacktrace *
+sr_stacktrace_parse_n(enum sr_report_type type, const char *input,
+                      size_t length, char **error_message)
+{
+    assert(type > SR_REPORT_INVALID && type < SR_REPORT_NUM);
+    parse_n_fn_t parse_n = dtable[type]->parse_n;
+    if (parse_n)
+        return parse_n(input, length, error_message);
+
+    /* The text parsers rely on the terminating NUL byte. */
+    if (memchr(input, '\0', length))
+        return sr_stacktrace_parse(type, input, error_message);
+
+    char *copy = sr_strndup(input, length);
+    struct sr_stacktrace *result = sr_stacktrace_parse(type, copy, error_message);
+    free(copy);
+    return result;
+}
+
 struct sr_stacktrace *
 sr_stacktrace_from_json(enum sr_report_type type, struct sr_json_value *root, char **error_message)
 {
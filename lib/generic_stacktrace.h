@@ -28,6 +28,7 @@ struct sr_strbuf;
 
 typedef struct sr_stacktrace* (*parse_fn_t)(const char *, char **);
 typedef struct sr_stacktrace* (*parse_location_fn_t)(const char **, struct sr_location *);
+typedef struct sr_stacktrace* (*parse_n_fn_t)(const char *, size_t, char **);
 typedef char* (*to_short_text_fn_t)(struct sr_stacktrace*, int);
 typedef char* (*to_json_fn_t)(struct sr_stacktrace *);
 typedef struct sr_stacktrace* (*from_json_fn_t)(struct sr_json_value *, char **);
@@ -43,6 +44,8 @@ struct stacktrace_methods
 {
     parse_fn_t parse;
     parse_location_fn_t parse_location;
+    /* optional, sr_stacktrace_parse_n() copies the input when NULL */
+    parse_n_fn_t parse_n;
     to_short_text_fn_t to_short_text;
     to_json_fn_t to_json;
     from_json_fn_t from_json;
@@ -0,0 +1,241 @@
+/*
+    hash_table.c
+
+    Copyright (C) 2013  Red Hat, Inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "hash_table.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BUCKETS 64
+
+struct hash_entry
+{
+    void *key;
+    void *value;
+    size_t hash;
+    struct hash_entry *next;
+};
+
+struct hash_table
+{
+    /* Number of buckets is always a power of two. */
+    struct hash_entry **buckets;
+    size_t bucket_count;
+    size_t size;
+    hash_fn hash;
+    equal_fn equal;
+    destroy_fn free_key;
+    destroy_fn free_value;
+};
+
+struct hash_table *
+hash_table_new(hash_fn hash,
+               equal_fn equal,
+               destroy_fn free_key,
+               destroy_fn free_value)
+{
+    struct hash_table *table = sr_malloc(sizeof(*table));
+    table->bucket_count = INITIAL_BUCKETS;
+    table->buckets = sr_mallocz(table->bucket_count * sizeof(*table->buckets));
+    table->size = 0;
+    table->hash = hash;
+    table->equal = equal;
+    table->free_key = free_key;
+    table->free_value = free_value;
+    return table;
+}
+
+static void
+free_entry(struct hash_table *table, struct hash_entry *entry)
+{
+    if (table->free_key)
+        table->free_key(entry->key);
+    if (table->free_value)
+        table->free_value(entry->value);
+    free(entry);
+}
+
+void
+hash_table_free(struct hash_table *table)
+{
+    if (!table)
+        return;
+
+    for (size_t i = 0; i < table->bucket_count; ++i)
+    {
+        struct hash_entry *entry = table->buckets[i];
+        while (entry)
+        {
+            struct hash_entry *next = entry->next;
+            free_entry(table, entry);
+            entry = next;
+        }
+    }
+
+    free(table->buckets);
+    free(table);
+}
+
+/* Returns the pointer pointing to the entry with the key, or to the NULL
+ * terminating the bucket if there is no such entry. */
+static struct hash_entry **
+find_entry(struct hash_table *table, const void *key, size_t hash)
+{
+    struct hash_entry **entry = &table->buckets[hash & (table->bucket_count - 1)];
+    while (*entry && ((*entry)->hash != hash || !table->equal((*entry)->key, key)))
+        entry = &(*entry)->next;
+
+    return entry;
+}
+
+static void
+grow(struct hash_table *table)
+{
+    size_t bucket_count = 2 * table->bucket_count;
+    struct hash_entry **buckets = sr_mallocz(bucket_count * sizeof(*buckets));
+
+    for (size_t i = 0; i < table->bucket_count; ++i)
+    {
+        struct hash_entry *entry = table->buckets[i];
+        while (entry)
+        {
+            struct hash_entry *next = entry->next;
+            size_t index = entry->hash & (bucket_count - 1);
+            entry->next = buckets[index];
+            buckets[index] = entry;
+            entry = next;
+        }
+    }
+
+    free(table->buckets);
+    table->buckets = buckets;
+    table->bucket_count = bucket_count;
+}
+
+bool
+hash_table_lookup(struct hash_table *table,
+                  const void *key,
+                  void **value)
+{
+    struct hash_entry *entry = *find_entry(table, key, table->hash(key));
+    if (!entry)
+        return false;
+
+    if (value)
+        *value = entry->value;
+
+    return true;
+}
+
+void
+hash_table_insert(struct hash_table *table,
+                  void *key,
+                  void *value)
+{
+    size_t hash = table->hash(key);
+    struct hash_entry **entry = find_entry(table, key, hash);
+    if (*entry)
+    {
+        if (table->free_key)
+            table->free_key(key);
+        if (table->free_value)
+            table->free_value((*entry)->value);
+
+        (*entry)->value = value;
+        return;
+    }
+
+    struct hash_entry *new_entry = sr_malloc(sizeof(*new_entry));
+    new_entry->key = key;
+    new_entry->value = value;
+    new_entry->hash = hash;
+    new_entry->next = NULL;
+    *entry = new_entry;
+
+    /* Keep the average chain length at most 1. */
+    if (++table->size > table->bucket_count)
+        grow(table);
+}
+
+bool
+hash_table_remove(struct hash_table *table,
+                  const void *key)
+{
+    struct hash_entry **entry = find_entry(table, key, table->hash(key));
+    if (!*entry)
+        return false;
+
+    struct hash_entry *removed = *entry;
+    *entry = removed->next;
+    free_entry(table, removed);
+    --table->size;
+    return true;
+}
+
+size_t
+hash_table_size(struct hash_table *table)
+{
+    return table->size;
+}
+
+void
+hash_table_foreach(struct hash_table *table,
+                   void (*callback)(void *key, void *value, void *data),
+                   void *data)
+{
+    for (size_t i = 0; i < table->bucket_count; ++i)
+    {
+        for (struct hash_entry *entry = table->buckets[i]; entry; entry = entry->next)
+            callback(entry->key, entry->value, data);
+    }
+}
+
+size_t
+hash_bytes(const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return (size_t)hash;
+}
+
+size_t
+hash_string(const void *string)
+{
+    const unsigned char *s = string;
+    uint64_t hash = 14695981039346656037ULL;
+    for (; *s; ++s)
+    {
+        hash ^= *s;
+        hash *= 1099511628211ULL;
+    }
+
+    return (size_t)hash;
+}
+
+bool
+string_equal(const void *string1, const void *string2)
+{
+    return 0 == strcmp(string1, string2);
+}
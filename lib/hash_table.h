@@ -0,0 +1,133 @@
+/*
+    hash_table.h
+
+    Copyright (C) 2013  Red Hat, Inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef SATYR_HASH_TABLE_H
+#define SATYR_HASH_TABLE_H
+
+/**
+ * @file
+ * @brief Hash table used by the caches and lookups of the library.
+ *
+ * The table maps opaque keys to opaque values.  The caller provides the
+ * hash and equality functions for the keys, and optionally functions
+ * releasing keys and values when they are removed from the table.
+ * The table is not thread-safe, callers sharing it between threads
+ * must lock it themselves.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct hash_table;
+
+typedef size_t (*hash_fn)(const void *key);
+typedef bool (*equal_fn)(const void *key1, const void *key2);
+typedef void (*destroy_fn)(void *data);
+
+/**
+ * Creates an empty hash table.
+ * @param free_key
+ * Called on the key when an entry is removed or the table is released.
+ * May be NULL.
+ * @param free_value
+ * Called on the value when an entry is removed or replaced, or the table
+ * is released.  May be NULL.
+ */
+struct hash_table *
+hash_table_new(hash_fn hash,
+               equal_fn equal,
+               destroy_fn free_key,
+               destroy_fn free_value);
+
+/**
+ * Releases the table together with all the keys and values.
+ */
+void
+hash_table_free(struct hash_table *table);
+
+/**
+ * Looks up the key.  Returns true if it is present and stores its value
+ * to *value, if value is not NULL.  The value itself may be NULL.
+ */
+bool
+hash_table_lookup(struct hash_table *table,
+                  const void *key,
+                  void **value);
+
+/**
+ * Inserts the key with the value.  If an equal key is already present,
+ * its value is replaced and the new key is released, so the table
+ * always takes ownership of both the key and the value.
+ */
+void
+hash_table_insert(struct hash_table *table,
+                  void *key,
+                  void *value);
+
+/**
+ * Removes the key and releases the stored key and value.  Returns false
+ * if the key was not present.
+ */
+bool
+hash_table_remove(struct hash_table *table,
+                  const void *key);
+
+/**
+ * Returns the number of entries in the table.
+ */
+size_t
+hash_table_size(struct hash_table *table);
+
+/**
+ * Calls the callback for every entry in an unspecified order.  The
+ * table must not be modified by the callback.
+ */
+void
+hash_table_foreach(struct hash_table *table,
+                   void (*callback)(void *key, void *value, void *data),
+                   void *data);
+
+/**
+ * FNV-1a hash of a memory area.
+ */
+size_t
+hash_bytes(const void *data, size_t size);
+
+/**
+ * FNV-1a hash of a NUL-terminated string, usable as hash_fn.
+ */
+size_t
+hash_string(const void *string);
+
+/**
+ * String equality usable as equal_fn.
+ */
+bool
+string_equal(const void *string1, const void *string2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
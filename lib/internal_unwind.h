@@ -20,6 +20,7 @@
 #ifndef SATYR_INTERNAL_UNWIND_H
 #define SATYR_INTERNAL_UNWIND_H
 
+#include <sys/types.h>
 #include <libelf.h>
 #include <gelf.h>
 #include <elfutils/libdwfl.h>
@@ -73,6 +74,10 @@ struct exe_mapping_data
     struct exe_mapping_data *next;
 };
 
+struct resolve_cache;
+struct sr_core_segment_index;
+struct sr_core_thread;
+
 struct core_handle
 {
     int fd;
@@ -80,6 +85,10 @@ struct core_handle
     Dwfl *dwfl;
     Dwfl_Callbacks cb;
     struct exe_mapping_data *segments;
+    /* The same modules sorted by address, with their Dwfl_Modules. */
+    struct sr_core_segment_index *segment_index;
+    /* Module and symbol lookups done by resolve_frame for this dwfl. */
+    struct resolve_cache *cache;
 };
 
 /* Gets dwfl handle and executable map data to be used for unwinding. The
@@ -90,12 +99,50 @@ open_coredump(const char *elf_file, const char *exe_file, char **error_msg);
 void
 core_handle_free(struct core_handle *ch);
 
+/* The segment index is filled by segment_index_add() and sorted by
+ * segment_index_sort() before the first lookup.  The module may be NULL,
+ * then the segment has no build id. */
+struct sr_core_segment_index *
+segment_index_new(void);
+
+void
+segment_index_add(struct sr_core_segment_index *index, Dwfl_Module *mod,
+                  Dwarf_Addr start, Dwarf_Addr end, const char *filename);
+
+void
+segment_index_sort(struct sr_core_segment_index *index);
+
+/* The segments may be NULL; otherwise they must outlive the cache. */
+struct resolve_cache *
+resolve_cache_new(const struct sr_core_segment_index *segments);
+
+void
+resolve_cache_free(struct resolve_cache *cache);
+
+/* Resolves the address to a frame.  The cache may be NULL; otherwise it
+ * must belong to the dwfl handle. */
 struct sr_core_frame *
-resolve_frame(Dwfl *dwfl, Dwarf_Addr ip, bool minus_one);
+resolve_frame(Dwfl *dwfl, Dwarf_Addr ip, bool minus_one,
+              struct resolve_cache *cache);
+
+/* Links the threads unwound in parallel to *threads in the order of the
+ * results.  If a result is NULL, all of them are freed, *threads is set
+ * to NULL and *error_msg to the error of the first failed thread, which
+ * is what the sequential unwinding reports.  A NULL result without an
+ * error is a thread left out because of another failure. */
+bool
+unwound_threads_merge(struct sr_core_thread **results, char **errors,
+                      size_t count, struct sr_core_thread **threads,
+                      char **error_msg);
 
 short
 get_signal_number(Elf *e, const char *elf_file);
 
+/* Same as get_signal_number(), and also stores the id of the thread that
+ * received the signal to *tid, if a signal is found and tid is not NULL. */
+short
+get_signal_and_tid(Elf *e, const char *elf_file, pid_t *tid);
+
 int
 find_debuginfo_none (Dwfl_Module *mod, void **userdata, const char *modname,
                      GElf_Addr base, const char *file_name,
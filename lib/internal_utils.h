@@ -57,6 +57,9 @@ warn(const char *fmt, ...) __sr_printf(1, 2);
 /* beware the side effects */
 #define OR_UNKNOWN(s) ((s) ? (s) : "<unknown>")
 
+/* The largest input file sr_file_to_string() reads, ~ 20 MB. */
+#define FILE_SIZE_LIMIT ((size_t)20000000)
+
 /* kerneloops taint flag structure and global table declaration */
 struct sr_taint_flag
 {
@@ -178,10 +178,21 @@ const static int
    flag_got_exponent_sign = 32, flag_escaped = 64, flag_string = 128, flag_need_colon = 256,
    flag_done = 512;
 
-struct sr_json_value *
-sr_json_parse_ex(struct sr_json_settings *settings,
-                  const char *json,
-                  struct sr_location *location)
+/* Returns the character at p, or '\0' when the end of a bounded
+ * input is reached.  Unbounded inputs pass NULL as end. */
+static inline char
+char_at(const char *p, const char *end)
+{
+    return (p == end ? '\0' : *p);
+}
+
+/* Parses the input up to the end pointer, or up to the terminating NUL
+ * character if end is NULL. */
+static struct sr_json_value *
+json_parse(struct sr_json_settings *settings,
+           const char *json,
+           const char *end,
+           struct sr_location *location)
 {
     const char *cur_line_begin, *i;
     struct sr_json_value *top, *root, *alloc = 0;
@@ -210,7 +221,7 @@ sr_json_parse_ex(struct sr_json_settings *settings,
 
         for (i = json ;; ++ i)
         {
-            char b = *i;
+            char b = char_at(i, end);
 
             if (flags & flag_done)
             {
@@ -254,8 +265,8 @@ sr_json_parse_ex(struct sr_json_settings *settings,
                     case 't':  string_add ('\t');  break;
                     case 'u':
 
-                        if ((uc_b1 = hex_value(*++i)) == 0xFF || (uc_b2 = hex_value(*++i)) == 0xFF
-                            || (uc_b3 = hex_value(*++i)) == 0xFF || (uc_b4 = hex_value(*++i)) == 0xFF)
+                        if ((uc_b1 = hex_value(char_at(++i, end))) == 0xFF || (uc_b2 = hex_value(char_at(++i, end))) == 0xFF
+                            || (uc_b3 = hex_value(char_at(++i, end))) == 0xFF || (uc_b4 = hex_value(char_at(++i, end))) == 0xFF)
                         {
                             location->column = e_off;
                             location->message = sr_asprintf("Invalid character value `%c`", b);
@@ -421,7 +432,7 @@ sr_json_parse_ex(struct sr_json_settings *settings,
                         string_length = 0;
                         continue;
                     case 't':
-                        if (*(++ i) != 'r' || *(++ i) != 'u' || *(++ i) != 'e')
+                        if (char_at(++ i, end) != 'r' || char_at(++ i, end) != 'u' || char_at(++ i, end) != 'e')
                             goto e_unknown_value;
 
                         if (!new_value(&state, &top, &root, &alloc, SR_JSON_BOOLEAN))
@@ -431,7 +442,7 @@ sr_json_parse_ex(struct sr_json_settings *settings,
                         flags |= flag_next;
                         break;
                     case 'f':
-                        if (*(++ i) != 'a' || *(++ i) != 'l' || *(++ i) != 's' || *(++ i) != 'e')
+                        if (char_at(++ i, end) != 'a' || char_at(++ i, end) != 'l' || char_at(++ i, end) != 's' || char_at(++ i, end) != 'e')
                             goto e_unknown_value;
 
                         if (!new_value(&state, &top, &root, &alloc, SR_JSON_BOOLEAN))
@@ -440,7 +451,7 @@ sr_json_parse_ex(struct sr_json_settings *settings,
                         flags |= flag_next;
                         break;
                     case 'n':
-                        if (*(++ i) != 'u' || *(++ i) != 'l' || *(++ i) != 'l')
+                        if (char_at(++ i, end) != 'u' || char_at(++ i, end) != 'l' || char_at(++ i, end) != 'l')
                             goto e_unknown_value;
 
                         if (!new_value(&state, &top, &root, &alloc, SR_JSON_NULL))
@@ -458,10 +469,32 @@ sr_json_parse_ex(struct sr_json_settings *settings,
                             if (state.first_pass)
                                 continue;
 
+                            /* A number at the very end of a bounded
+                             * input is not terminated, so it must be
+                             * copied before it is converted. */
+                            const char *number = i;
+                            char *number_copy = NULL;
+                            if (end)
+                            {
+                                const char *number_last = i;
+                                while (number_last != end && *number_last
+                                       && strchr("+-.eE0123456789", *number_last))
+                                {
+                                    ++number_last;
+                                }
+
+                                if (number_last == end)
+                                    number = number_copy = sr_strndup(i, end - i);
+                            }
+
+                            char *number_end;
                             if (top->type == SR_JSON_DOUBLE)
-                                top->u.dbl = strtod(i, (char**)&i);
+                                top->u.dbl = strtod(number, &number_end);
                             else
-                                top->u.integer = strtoll(i, (char**)&i, 10);
+                                top->u.integer = strtoll(number, &number_end, 10);
+
+                            i += number_end - number;
+                            free(number_copy);
 
                             flags |= flag_next | flag_reproc;
                         }
@@ -635,6 +668,14 @@ sr_json_parse_ex(struct sr_json_settings *settings,
     return NULL;
 }
 
+struct sr_json_value *
+sr_json_parse_ex(struct sr_json_settings *settings,
+                  const char *json,
+                  struct sr_location *location)
+{
+    return json_parse(settings, json, NULL, location);
+}
+
 struct sr_json_value *
 sr_json_parse(const char *json, char **error_message)
 {
@@ -651,6 +692,23 @@ sr_json_parse(const char *json, char **error_message)
     return json_root;
 }
 
+struct sr_json_value *
+sr_json_parse_n(const char *json, size_t length, char **error_message)
+{
+    struct sr_json_settings settings;
+    memset(&settings, 0, sizeof(struct sr_json_settings));
+    struct sr_location location;
+    sr_location_init(&location);
+    struct sr_json_value *json_root = json_parse(&settings, json,
+                                                 json + length,
+                                                 &location);
+
+    if (!json_root)
+        *error_message = sr_location_to_string(&location);
+
+    return json_root;
+}
+
 void
 sr_json_value_free(struct sr_json_value *value)
 {
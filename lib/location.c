@@ -21,6 +21,7 @@
 #include "utils.h"
 #include "strbuf.h"
 #include <stdlib.h>
+#include <string.h>
 
 void
 sr_location_init(struct sr_location *location)
@@ -113,3 +114,33 @@ sr_location_eat_char_ext(int *line,
     else
         *column += 1;
 }
+
+void
+sr_location_eat_chars(struct sr_location *location,
+                      const char *s,
+                      size_t length)
+{
+    sr_location_eat_chars_ext(&location->line,
+                              &location->column,
+                              s,
+                              length);
+}
+
+void
+sr_location_eat_chars_ext(int *line,
+                          int *column,
+                          const char *s,
+                          size_t length)
+{
+    /* Only the newlines are visited one by one; memchr skips over the
+     * rest of the text in large steps. */
+    const char *end = s + length, *newline;
+    while ((newline = memchr(s, '\n', end - s)) != NULL)
+    {
+        *line += 1;
+        *column = 0;
+        s = newline + 1;
+    }
+
+    *column += end - s;
+}
@@ -25,334 +25,661 @@
 #include "core/thread.h"
 #include "thread.h"
 #include "utils.h"
+#include "hash_table.h"
+#include <pthread.h>
 #include <string.h>
 #include <assert.h>
 
-static bool
-call_match(const char *function_name,
-           const char *source_file,
-           const char *expected_function_name,
-           ...)
+/* A frame matches a rule if it calls the function and its source file
+ * contains one of the strings.  An empty string matches every known
+ * source file. */
+struct normalize_rule
 {
-    if (!function_name)
-        return false;
+    const char *function_name;
+    const char *const *source_files;
+};
 
-    if (0 != strcmp(function_name, expected_function_name))
-        return false;
+#define RULE(function_name, ...) \
+    { function_name, (const char *const []){ __VA_ARGS__, NULL } }
+
+/* Frames which are not a cause of the crash. */
+static const struct normalize_rule
+removable_rules[] =
+{
+    /* Vim */
+    RULE("may_core_dump", "os_unix.c"),
+    RULE("mch_exit", "os_unix.c"),
+
+    /* Java virtual machine */
+    RULE("os::abort", "os_linux.cpp"),
+    RULE("VMError::report_and_die", "vmError.cpp"),
+    RULE("JVM_handle_linux_signal", "os_linux_x86.cpp"),
+
+    /* D-Bus */
+    RULE("gerror_to_dbus_error_message", "dbus-gobject.c"),
+    RULE("dbus_g_method_return_error", "dbus-gobject.c"),
+    RULE("message_queue_dispatch", "dbus-gmain.c"),
+    RULE("_dbus_abort", "dbus-sysdeps.c", "libdbus"),
+    RULE("dbus_connection_dispatch", "dbus-connection.c", "libdbus"),
+
+    /* GDK */
+    RULE("gdk_x_error", "gdkmain-x11.c"),
+    RULE("gdk_threads_dispatch", "gdk.c"),
+    RULE("gdk_event_dispatch", "gdkevents-x11.c", "gdkevents.c"),
+    RULE("gdk_event_source_dispatch", "gdkeventsource.c"),
+    RULE("_gdk_x11_display_error_event", "gdkdisplay-x11.c", "libgdk"),
+
+    /* GLib and GObject */
+    RULE("g_log", "gmessages.c", "libglib"),
+    RULE("g_logv", "gmessages.c", "libglib"),
+    RULE("g_assertion_message", "gtestutils.c", "libglib"),
+    RULE("g_assertion_message_expr", "gtestutils.c", "libglib"),
+    RULE("g_closure_invoke", "gclosure.c", "libgobject"),
+    RULE("g_free", "gmem.c", "libglib"),
+    RULE("g_type_class_meta_marshal", "gclosure.c", "libglib"),
+    RULE("g_signal_emit_valist", "gsignal.c", "libgobject"),
+    RULE("signal_emit_unlocked_R", "gsignal.c", "libgobject"),
+    RULE("g_signal_emit", "gsignal.c", "libgobject"),
+    RULE("g_idle_dispatch", "gmain.c", "gutf8.c"),
+    RULE("g_object_dispatch_properties_changed", "gobject.c", "libgobject"),
+    RULE("g_object_notify_dispatcher", "gobject.c", "libgobject"),
+    RULE("g_object_unref", "gobject.c", "libgobject"),
+    RULE("g_object_run_dispose", "gobject.c", "libgobject"),
+    RULE("g_object_new", "gobject.c", "libgobject"),
+    RULE("g_object_newv", "gobject.c", "libgobject"),
+    RULE("g_main_context_dispatch", "gmain.c", "libglib"),
+    RULE("g_main_context_iterate", "gmain.c", "libglib"),
+    RULE("g_main_dispatch", "gmain.c", "libglib"),
+    RULE("g_main_loop_run", "gmain.c", "libglib"),
+    RULE("g_timeout_dispatch", "gmain.c", "libglib"),
+    RULE("g_thread_pool_thread_proxy", "gthreadpool.c", "libglib"),
+    RULE("g_thread_create_proxy", "gthread.c", "libglib"),
+    RULE("g_cclosure_marshal_VOID__BOXED", "gmarshal.c", "libgobject"),
+    RULE("g_cclosure_marshal_VOID__VOID", "gclosure.c", "gmarshal.c", "libgobject"),
+    RULE("g_object_notify", "gobject.c", "libgobject"),
+    RULE("Glib::exception_handlers_invoke()", "libglibmm"),
+    RULE("g_signal_handlers_destroy", "gsignal.c", "libgobject"),
+    RULE("g_vasprintf", "gprintf.c", "libglib"),
+    RULE("g_strdup_vprintf", "libglib"),
+    RULE("g_strdup_printf", "libglib"),
+    RULE("g_print", "libglib"),
+    RULE("invalid_closure_notify", "gsignal.c", "libgobject"),
+    RULE("smc_tree_abort", "gslice.c", "libglib"),
+    RULE("g_thread_abort", "libglib"),
+
+    /* libstdc++ */
+    RULE("__gnu_cxx::__verbose_terminate_handler", "vterminate.cc"),
+    RULE("__cxxabiv1::__terminate", "eh_terminate.cc"),
+    RULE("std::terminate", "eh_terminate.cc"),
+    RULE("__cxxabiv1::__cxa_throw", "eh_throw.cc"),
+    RULE("__cxxabiv1::__cxa_rethrow", "eh_throw.cc"),
+    RULE("__verbose_terminate_handler", "vterminate.cc"),
+    RULE("__cxxabiv1::__cxa_pure_virtual", "pure.cc"),
+
+    /* Linux kernel */
+    RULE("__kernel_vsyscall", ""),
+
+    /* X.Org */
+    RULE("_XReply", "xcb_io.c"),
+    RULE("_XError", "XlibInt.c"),
+    RULE("XSync", "Sync.c"),
+    RULE("process_responses", "xcb_io.c"),
+    RULE("OsSigHandler", "osinit.c"),
+    RULE("FatalError", "log.c"),
+    RULE("AbortServer", "log.c"),
+    RULE("AbortDDX", "xf86Init.c"),
+    RULE("ddxGiveUp", "xf86Init.c"),
+    RULE("OsAbort", "utils.c"),
+    RULE("handle_error", "xcb_io.c", "libX11"),
+    RULE("_XIOError", "XlibInt.c", "libX11"),
+    RULE("_XEventsQueued", "xcb_io.c", "libX11"),
+    RULE("handle_response", "xcb_io.c", "libX11"),
+
+    /* glibc */
+    RULE("_start", ""),
+    RULE("__libc_start_main", "libc"),
+    RULE("clone", "clone.S", "libc"),
+    RULE("poll", "libc"),
+    RULE("_IO_new_fclose", "iofclose.c", "libc"),
+    RULE("_IO_vfprintf_internal", "vfprintf.c", "libc"),
+    RULE("_IO_default_xsputn", "genops.c", "libc"),
+    RULE("_IO_wdefault_xsputn", "wgenops.c", "libc"),
+    RULE("__libc_message", "libc_fatal.c", "libc"),
+    RULE("start_thread", "pthread_create.c", "libpthread"),
+
+    /* Other programs and libraries */
+    RULE("assert_cursor", "intel_display.c"),
+    RULE("assert_device_not_suspended", "intel_uncore.c"),
+    RULE("assert_pipe", "intel_display.c"),
+    RULE("assert_plane", "intel_display.c"),
+    RULE("assert_transcoder_disabled", "intel_display.c"),
+    RULE("btrfs_assert_delayed_root_empty", "delayed-inode.c", "btrfs"),
+    RULE("_cogl_set_error", "cogl-error.c", "libcogl"),
+    RULE("defaultCrashHandler", "kcrash.cpp", "libKF5Crash"),
+    RULE("_dl_signal_error", "dl-error.c", "ld-linux"),
+    RULE("error_dialog_response_cb", ""),
+    RULE("do_warn", "_warnings.c", "libpython"),
+    RULE("QMessageLogger::fatal(char const*, ...) const", ""),
+    RULE("nsProfileLock::FatalSignalHandler(int, siginfo_t*, void*)", ""),
+    RULE("qt_message_output", "qglobal.cpp", "libQtCore"),
+    RULE("qt_message_output(QtMsgType, char const*)", ""),
+    RULE("signalHandler(int, siginfo_t*, void*)", ""),
+    RULE("FatalSignalHandler", "nsProfileLock.cpp", "libxul"),
+    RULE("Foam::error::abort()", ""),
+    RULE("JS_AbortIfWrongThread", "libmozjs"),
+    RULE("Crash::defaultCrashHandler(int)", "libkdeui", "libKF5Crash"),
+    RULE("Py_FatalError", "pythonrun.c", "libpython"),
+    RULE("__btrfs_abort_transaction", "btrfs"),
+    RULE("assert_pch_hdmi_disabled", ""),
+    RULE("assert_pll", ""),
+    RULE("core::system::abort()", ""),
+    RULE("ddd_assert_fail", "assert.C"),
+    RULE("debug_dma_assert_idle", ""),
+    RULE("error_handler", ""),
+    RULE("fatal_error_signal", ""),
+    RULE("fatal_handler", "signal.c", "libfreerdp"),
+    RULE("gpf_notice", ""),
+    RULE("log", ""),
+    RULE("_log", ""),
+    RULE("log_assert_failed", ""),
+    RULE("mozalloc_abort", "mozalloc_abort.cpp", "libmozalloc"),
+    RULE("mozalloc_abort(char const*)", "libmozalloc", "content-container", "plugin-container"),
+    RULE("note_interrupt", "spurious.c", "vmlinux"),
+    RULE("print_bad_pte", "memory.c", "vmlinux"),
+    RULE("print_oops_end_marker", "panic.c", "vmlinux"),
+    RULE("printk", "printk.c", "vmlinux"),
+    RULE("qupzilla_signal_handler", "main.cpp", "qupzilla"),
+    RULE("rb_bug", "error.c", "libruby"),
+    RULE("sighandler", ""),
+    RULE("signalHandler(int)", ""),
+    RULE("signal_abort", "signal.c"),
+    RULE("signal_handler", ""),
+    RULE("sys_abort", "error.c", "libgfortran"),
+    RULE("terminate_due_to_signal", "emacs.c", "emacs"),
+    RULE("wl_log", "wayland-util.c"),
+    RULE("display_protocol_error", "wayland-client.c"),
+    RULE("display_handle_error", "wayland-client.c"),
+    RULE("x_io_error", "libmutter"),
+    RULE("__ioremap_calle ", "ioremap.c"),
+    RULE("ioremap_nocache", "ioremap.c"),
+    RULE("wpa_msg", "wpa_debug.c"),
+    RULE("js::gc::FinalizeArenas(js::FreeOp*, js::gc::ArenaHeader**, js::gc::ArenaList&, js::gc::AllocKind, js::SliceBudget&)\"js::Shape::finalize(js::FreeOp*)", ""),
+    RULE("WTF::StringImpl::endsWith(char const*, unsigned int, bool) const", ""),
+    RULE("mozilla::plugins::child::_invokedefault(_NPP*, NPObject*, _NPVariant const*, unsigned int, _NPVariant*)", ""),
+    RULE("xitk_signal_handler", "xitk.c", "xine"),
+};
+
+/* Frames which are removed together with all the frames above them. */
+static const struct normalize_rule
+removable_with_above_rules[] =
+{
+    RULE("__assert_fail", ""),
+    RULE("__assert_fail_base", ""),
+    RULE("__chk_fail", ""),
+    RULE("__longjmp_chk", ""),
+    RULE("__malloc_assert", ""),
+    RULE("__strcat_chk", ""),
+    RULE("__strcpy_chk", ""),
+    RULE("__strncpy_chk", ""),
+    RULE("__vsnprintf_chk", ""),
+    RULE("___vsnprintf_chk", ""),
+    RULE("__snprintf_chk", ""),
+    RULE("___snprintf_chk", ""),
+    RULE("__vasprintf_chk", ""),
+    RULE("__vsprintf_chk", ""),
+    RULE("___sprintf_chk", ""),
+    RULE("__fwprintf_chk", ""),
+    RULE("__asprintf_chk", ""),
+    RULE("___printf_chk", ""),
+    RULE("___fprintf_chk", ""),
+    RULE("__vswprintf_chk", ""),
+    RULE("malloc_consolidate", "malloc.c", "libc"),
+    RULE("malloc_printerr", "malloc.c", "libc"),
+    RULE("_int_malloc", "malloc.c", "libc"),
+    RULE("_int_free", "malloc.c", "libc"),
+    RULE("_int_realloc", "malloc.c", "libc"),
+    RULE("_int_memalign", "malloc.c"),
+    RULE("__libc_free", "malloc.c"),
+    RULE("__libc_malloc", "malloc.c"),
+    RULE("__libc_memalign", "malloc.c"),
+    RULE("__libc_realloc", "malloc.c"),
+    RULE("__posix_memalign", "malloc.c"),
+    RULE("__libc_calloc", "malloc.c"),
+    RULE("__libc_fatal", "libc"),
+};
+
+/* Frames of a gdb stacktrace which terminate the program, see
+ * sr_glibc_thread_find_exit_frame(). */
+static const struct normalize_rule
+gdb_exit_frames[] =
+{
+    RULE("__run_exit_handlers", "exit.c"),
+    RULE("raise", "pt-raise.c", "libc.so", "libc-", "libpthread.so"),
+    RULE("__GI_raise", "raise.c"),
+    RULE("exit", "exit.c"),
+    RULE("abort", "abort.c", "libc.so", "libc-"),
+    RULE("__GI_abort", "abort.c"),
+    /* Terminates a function in case of buffer overflow. */
+    RULE("__chk_fail", "chk_fail.c", "libc.so"),
+    RULE("__stack_chk_fail", "stack_chk_fail.c", "libc.so"),
+    RULE("do_exit", "exit.c"),
+    RULE("kill", "syscall-template.S"),
+};
+
+/* The same for core stacktraces, see sr_core_thread_is_exit_frame().  A
+ * rule without files matches any frame of the function. */
+#define ANY_FILE_RULE(function_name) \
+    { function_name, (const char *const []){ NULL } }
+
+static const struct normalize_rule
+core_exit_frames[] =
+{
+    ANY_FILE_RULE("__run_exit_handlers"),
+    RULE("raise", "libc.so", "libc-", "libpthread.so"),
+    ANY_FILE_RULE("__GI_raise"),
+    ANY_FILE_RULE("exit"),
+    RULE("abort", "libc.so", "libc-"),
+    ANY_FILE_RULE("__GI_abort"),
+    RULE("__chk_fail", "libc.so"),
+    RULE("__stack_chk_fail", "libc.so"),
+    ANY_FILE_RULE("kill"),
+};
+
+#undef ANY_FILE_RULE
+#undef RULE
+
+/* Architecture-specific variants of glibc string functions, which are
+ * renamed to the generic function.  The variant "__memchr_sse2" of
+ * "memchr" is renamed in source files containing "memchr", "/sysdeps/"
+ * or "libc.so". */
+static const char *const
+arch_specific_functions[] =
+{
+    "memchr",
+    "memcmp",
+    "memcpy",
+    "memmove",
+    "memset",
+    "rawmemchr",
+    "strcasecmp",
+    "strcasecmp_l",
+    "strcat",
+    "strchr",
+    "strchrnul",
+    "strcmp",
+    "strcpy",
+    "strcspn",
+    "strlen",
+    "strncmp",
+    "strncpy",
+    "strpbrk",
+    "strrchr",
+    "strspn",
+    "strstr",
+    "strtok",
+};
+
+static const struct
+{
+    const char *suffix;
+    const char *sysdeps;
+}
+arch_specific_suffixes[] =
+{
+    { "_sse2", "/sysdeps/" },
+    { "_sse2_bsf", "/sysdeps/" },
+    { "_ssse3", "/sysdeps/" }, /* ssse3, not sse3! */
+    { "_ssse3_rep", "/sysdeps/" },
+    { "_ssse3_back", "/sysdeps/" },
+    { "_sse42", "/sysdeps/" },
+    { "_ia32", "/sysdeps" },
+};
+
+enum rule_kind
+{
+    RULE_REMOVE,
+    RULE_REMOVE_WITH_ABOVE,
+    RULE_RENAME,
+    RULE_GDB_EXIT,
+    RULE_CORE_EXIT,
+};
+
+struct compiled_rule
+{
+    enum rule_kind kind;
+    /* NULL-terminated.  An empty list matches every frame, even one
+     * without a source file. */
+    char **source_files;
+    /* Only for RULE_RENAME. */
+    char *new_function_name;
+    struct compiled_rule *next;
+};
+
+/* The rules compiled into a map from the function name to the list of
+ * its rules, so that matching a frame takes a single lookup.  The built-in
+ * rules are compiled on first use; sr_normalize_load_rules() adds more
+ * under the write lock. */
+static struct hash_table *compiled_rules;
+static pthread_once_t compiled_rules_once = PTHREAD_ONCE_INIT;
+static pthread_rwlock_t compiled_rules_lock = PTHREAD_RWLOCK_INITIALIZER;
 
-    va_list source_files;
-    va_start(source_files, expected_function_name);
-    bool success = false;
+static void
+compiled_rule_free(void *data)
+{
+    struct compiled_rule *rule = data;
+    while (rule)
+    {
+        struct compiled_rule *next = rule->next;
+        for (char **file = rule->source_files; *file; ++file)
+            free(*file);
+
+        free(rule->source_files);
+        free(rule->new_function_name);
+        free(rule);
+        rule = next;
+    }
+}
 
-    while (true)
+/* Must be called with the write lock held, or before the table is
+ * published. */
+static void
+add_rule(enum rule_kind kind,
+         const char *function_name,
+         const char *const *source_files,
+         size_t source_file_count,
+         const char *new_function_name)
+{
+    struct compiled_rule *rule = sr_malloc(sizeof(*rule));
+    rule->kind = kind;
+    rule->source_files = sr_malloc_array(source_file_count + 1,
+                                         sizeof(*rule->source_files));
+    for (size_t i = 0; i < source_file_count; ++i)
+        rule->source_files[i] = sr_strdup(source_files[i]);
+
+    rule->source_files[source_file_count] = NULL;
+    rule->new_function_name = (new_function_name
+                               ? sr_strdup(new_function_name) : NULL);
+
+    void *first;
+    if (hash_table_lookup(compiled_rules, function_name, &first))
     {
-        char *expected_source_file = va_arg(source_files, char*);
-        if (!expected_source_file)
-            break;
+        /* Keep the order in which the rules were added. */
+        struct compiled_rule *last = first;
+        while (last->next)
+            last = last->next;
 
-        if (source_file &&
-            NULL != strstr(source_file, expected_source_file))
-        {
-            success = true;
-            break;
-        }
+        rule->next = NULL;
+        last->next = rule;
+    }
+    else
+    {
+        rule->next = NULL;
+        hash_table_insert(compiled_rules, sr_strdup(function_name), rule);
     }
+}
 
-    va_end(source_files);
-    return success;
+static void
+add_rules(enum rule_kind kind,
+          const struct normalize_rule *rules,
+          size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t source_file_count = 0;
+        while (rules[i].source_files[source_file_count])
+            ++source_file_count;
+
+        add_rule(kind, rules[i].function_name, rules[i].source_files,
+                 source_file_count, NULL);
+    }
 }
 
-static bool
-is_removable_vim(const char *function_name,
-                 const char *source_file)
+static void
+compile_builtin_rules(void)
 {
-    return
-        call_match(function_name, source_file, "may_core_dump", "os_unix.c", NULL) ||
-        call_match(function_name, source_file, "mch_exit", "os_unix.c", NULL);
+    compiled_rules = hash_table_new(hash_string, string_equal,
+                                    free, compiled_rule_free);
+
+    add_rules(RULE_REMOVE, removable_rules,
+              sizeof(removable_rules) / sizeof(removable_rules[0]));
+    add_rules(RULE_REMOVE_WITH_ABOVE, removable_with_above_rules,
+              sizeof(removable_with_above_rules) / sizeof(removable_with_above_rules[0]));
+    add_rules(RULE_GDB_EXIT, gdb_exit_frames,
+              sizeof(gdb_exit_frames) / sizeof(gdb_exit_frames[0]));
+    add_rules(RULE_CORE_EXIT, core_exit_frames,
+              sizeof(core_exit_frames) / sizeof(core_exit_frames[0]));
+
+    for (size_t i = 0; i < sizeof(arch_specific_functions) / sizeof(arch_specific_functions[0]); ++i)
+    {
+        for (size_t j = 0; j < sizeof(arch_specific_suffixes) / sizeof(arch_specific_suffixes[0]); ++j)
+        {
+            const char *function = arch_specific_functions[i];
+            const char *source_files[] = {
+                function, arch_specific_suffixes[j].sysdeps, "libc.so"
+            };
+
+            char *variant = sr_asprintf("__%s%s", function,
+                                        arch_specific_suffixes[j].suffix);
+            add_rule(RULE_RENAME, variant, source_files, 3, function);
+            free(variant);
+        }
+    }
 }
 
-static bool
-is_removable_jvm(const char *function_name,
-                 const char *source_file)
+/* Takes the read lock; release it by unlock_rules(). */
+static void
+lock_rules(void)
 {
-    return
-        call_match(function_name, source_file, "os::abort", "os_linux.cpp", NULL) ||
-        call_match(function_name, source_file, "VMError::report_and_die", "vmError.cpp", NULL) ||
-        call_match(function_name, source_file, "JVM_handle_linux_signal", "os_linux_x86.cpp", NULL);
+    pthread_once(&compiled_rules_once, compile_builtin_rules);
+    pthread_rwlock_rdlock(&compiled_rules_lock);
 }
 
-static bool
-is_removable_dbus(const char *function_name,
-                  const char *source_file)
-{
-    return
-        call_match(function_name, source_file, "gerror_to_dbus_error_message", "dbus-gobject.c", NULL) ||
-        call_match(function_name, source_file, "dbus_g_method_return_error", "dbus-gobject.c", NULL) ||
-        call_match(function_name, source_file, "message_queue_dispatch", "dbus-gmain.c", NULL) ||
-        call_match(function_name, source_file, "_dbus_abort", "dbus-sysdeps.c", "libdbus", NULL) ||
-        call_match(function_name, source_file, "dbus_connection_dispatch", "dbus-connection.c", "libdbus", NULL);
+static void
+unlock_rules(void)
+{
+    pthread_rwlock_unlock(&compiled_rules_lock);
 }
 
 static bool
-is_removable_gdk(const char *function_name,
-                 const char *source_file)
-{
-    return
-        call_match(function_name, source_file, "gdk_x_error", "gdkmain-x11.c", NULL) ||
-        call_match(function_name, source_file, "gdk_threads_dispatch", "gdk.c", NULL) ||
-        call_match(function_name, source_file, "gdk_event_dispatch", "gdkevents-x11.c", "gdkevents.c", NULL) ||
-        call_match(function_name, source_file, "gdk_event_source_dispatch", "gdkeventsource.c", NULL) ||
-        call_match(function_name, source_file, "_gdk_x11_display_error_event", "gdkdisplay-x11.c", "libgdk", NULL);
+rule_matches(const struct compiled_rule *rule, const char *source_file)
+{
+    if (!rule->source_files[0])
+        return true;
+
+    if (!source_file)
+        return false;
+
+    for (char **file = rule->source_files; *file; ++file)
+    {
+        if (strstr(source_file, *file))
+            return true;
+    }
+
+    return false;
 }
 
-static bool
-is_removable_glib(const char *function_name,
-                  const char *source_file)
-{
-    return
-        call_match(function_name, source_file, "g_log", "gmessages.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_logv", "gmessages.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_assertion_message", "gtestutils.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_assertion_message_expr", "gtestutils.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_closure_invoke", "gclosure.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_free", "gmem.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_type_class_meta_marshal", "gclosure.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_signal_emit_valist", "gsignal.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "signal_emit_unlocked_R", "gsignal.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_signal_emit", "gsignal.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_idle_dispatch", "gmain.c", "gutf8.c", NULL) ||
-        call_match(function_name, source_file, "g_object_dispatch_properties_changed", "gobject.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_object_notify_dispatcher", "gobject.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_object_unref", "gobject.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_object_run_dispose", "gobject.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_object_new", "gobject.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_object_newv", "gobject.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_main_context_dispatch", "gmain.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_main_context_iterate", "gmain.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_main_dispatch", "gmain.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_main_loop_run", "gmain.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_timeout_dispatch", "gmain.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_thread_pool_thread_proxy", "gthreadpool.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_thread_create_proxy", "gthread.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_cclosure_marshal_VOID__BOXED", "gmarshal.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_cclosure_marshal_VOID__VOID", "gclosure.c", "gmarshal.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_object_notify", "gobject.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "Glib::exception_handlers_invoke()", "libglibmm", NULL) ||
-        call_match(function_name, source_file, "g_signal_handlers_destroy", "gsignal.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "g_vasprintf", "gprintf.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_strdup_vprintf", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_strdup_printf", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_print", "libglib", NULL) ||
-        call_match(function_name, source_file, "invalid_closure_notify", "gsignal.c", "libgobject", NULL) ||
-        call_match(function_name, source_file, "smc_tree_abort", "gslice.c", "libglib", NULL) ||
-        call_match(function_name, source_file, "g_thread_abort", "libglib", NULL);
+/* Must be called with the lock held. */
+static const struct compiled_rule *
+find_rule(const char *function_name, const char *source_file,
+          enum rule_kind kind)
+{
+    void *rule;
+    if (!function_name
+        || !hash_table_lookup(compiled_rules, function_name, &rule))
+    {
+        return NULL;
+    }
+
+    for (const struct compiled_rule *r = rule; r; r = r->next)
+    {
+        if (r->kind == kind && rule_matches(r, source_file))
+            return r;
+    }
+
+    return NULL;
 }
 
-static bool
-is_removable_libstdcpp(const char *function_name,
+/* Must be called with the lock held. */
+static char *
+find_new_function_name(const char *function_name,
                        const char *source_file)
 {
-    return
-        call_match(function_name, source_file, "__gnu_cxx::__verbose_terminate_handler", "vterminate.cc", NULL) ||
-        call_match(function_name, source_file, "__cxxabiv1::__terminate", "eh_terminate.cc", NULL) ||
-        call_match(function_name, source_file, "std::terminate", "eh_terminate.cc", NULL) ||
-        call_match(function_name, source_file, "__cxxabiv1::__cxa_throw", "eh_throw.cc", NULL) ||
-        call_match(function_name, source_file, "__cxxabiv1::__cxa_rethrow", "eh_throw.cc", NULL) ||
-        call_match(function_name, source_file, "__verbose_terminate_handler", "vterminate.cc", NULL) ||
-        call_match(function_name, source_file, "__cxxabiv1::__cxa_pure_virtual", "pure.cc", NULL);
+    const struct compiled_rule *rule = find_rule(function_name, source_file,
+                                                 RULE_RENAME);
+
+    return (rule ? sr_strdup(rule->new_function_name) : NULL);
 }
 
+/* Most fields a line of a rules file may have. */
+#define MAX_RULE_FIELDS 64
+
+/* A rule read from a file, pointing to the contents of the file. */
+struct parsed_rule
+{
+    enum rule_kind kind;
+    const char *function_name;
+    const char *new_function_name;
+    /* The source files are fields[first_file] to fields[count - 1]. */
+    size_t first_file;
+    size_t count;
+    const char *fields[MAX_RULE_FIELDS];
+};
+
+/* Splits the line in place and fills the rule.  Returns false and sets
+ * *error_message on a malformed line. */
 static bool
-is_removable_linux(const char *function_name,
-                   const char *source_file)
+parse_rule_line(char *line, const char *filename, unsigned line_number,
+                struct parsed_rule *rule, char **error_message)
 {
-    return call_match(function_name, source_file, "__kernel_vsyscall", "", NULL);
-}
+    /* KIND, FUNCTION[, NEW_NAME], SOURCE_FILE... separated by tabs. */
+    size_t count = 0;
+    for (char *field = line; field; ++count)
+    {
+        if (count == MAX_RULE_FIELDS)
+        {
+            *error_message = sr_asprintf("%s:%u: More than %d fields",
+                                         filename, line_number,
+                                         MAX_RULE_FIELDS);
+            return false;
+        }
 
-static bool
-is_removable_xorg(const char *function_name,
-                  const char *source_file)
-{
-    return
-        call_match(function_name, source_file, "_XReply", "xcb_io.c", NULL) ||
-        call_match(function_name, source_file, "_XError", "XlibInt.c", NULL) ||
-        call_match(function_name, source_file, "XSync", "Sync.c", NULL) ||
-        call_match(function_name, source_file, "process_responses", "xcb_io.c", NULL) ||
-        call_match(function_name, source_file, "OsSigHandler", "osinit.c", NULL) ||
-        call_match(function_name, source_file, "FatalError", "log.c", NULL) ||
-        call_match(function_name, source_file, "AbortServer", "log.c", NULL) ||
-        call_match(function_name, source_file, "AbortDDX", "xf86Init.c", NULL) ||
-        call_match(function_name, source_file, "ddxGiveUp", "xf86Init.c", NULL) ||
-        call_match(function_name, source_file, "OsAbort", "utils.c", NULL) ||
-        call_match(function_name, source_file, "handle_error", "xcb_io.c", "libX11", NULL) ||
-        call_match(function_name, source_file, "_XIOError", "XlibInt.c", "libX11", NULL) ||
-        call_match(function_name, source_file, "_XEventsQueued", "xcb_io.c", "libX11", NULL) ||
-        call_match(function_name, source_file, "handle_response", "xcb_io.c", "libX11", NULL);
-}
+        rule->fields[count] = field;
+        field = strchr(field, '\t');
+        if (field)
+            *field++ = '\0';
+    }
 
-static bool
-is_removable_glibc(const char *function_name,
-                   const char *source_file)
-{
-    return
-        call_match(function_name, source_file, "_start", "", NULL) ||
-        call_match(function_name, source_file, "__libc_start_main", "libc", NULL) ||
-        call_match(function_name, source_file, "clone", "clone.S", "libc", NULL) ||
-        call_match(function_name, source_file, "poll", "libc", NULL) ||
-        call_match(function_name, source_file, "_IO_new_fclose", "iofclose.c", "libc", NULL) ||
-        call_match(function_name, source_file, "_IO_vfprintf_internal", "vfprintf.c", "libc", NULL) ||
-        call_match(function_name, source_file, "_IO_default_xsputn", "genops.c", "libc", NULL) ||
-        call_match(function_name, source_file, "_IO_wdefault_xsputn", "wgenops.c", "libc", NULL) ||
-        call_match(function_name, source_file, "__libc_message", "libc_fatal.c", "libc", NULL) ||
-        call_match(function_name, source_file, "start_thread", "pthread_create.c", "libpthread", NULL);
-}
+    size_t first_file = 2;
+    if (0 == strcmp(rule->fields[0], "remove"))
+        rule->kind = RULE_REMOVE;
+    else if (0 == strcmp(rule->fields[0], "remove-with-above"))
+        rule->kind = RULE_REMOVE_WITH_ABOVE;
+    else if (0 == strcmp(rule->fields[0], "rename"))
+    {
+        rule->kind = RULE_RENAME;
+        first_file = 3;
+    }
+    else
+    {
+        *error_message = sr_asprintf("%s:%u: Unknown rule '%s'",
+                                     filename, line_number, rule->fields[0]);
+        return false;
+    }
 
-static bool
-is_removable_other(const char *function_name,
-                   const char *source_file)
-{
-    return
-        call_match(function_name, source_file, "assert_cursor", "intel_display.c", NULL) ||
-        call_match(function_name, source_file, "assert_device_not_suspended", "intel_uncore.c", NULL) ||
-        call_match(function_name, source_file, "assert_pipe", "intel_display.c", NULL) ||
-        call_match(function_name, source_file, "assert_plane", "intel_display.c", NULL) ||
-        call_match(function_name, source_file, "assert_transcoder_disabled", "intel_display.c", NULL) ||
-        call_match(function_name, source_file, "btrfs_assert_delayed_root_empty", "delayed-inode.c", "btrfs", NULL) ||
-        call_match(function_name, source_file, "_cogl_set_error", "cogl-error.c", "libcogl", NULL) ||
-        call_match(function_name, source_file, "defaultCrashHandler", "kcrash.cpp", "libKF5Crash", NULL) ||
-        call_match(function_name, source_file, "_dl_signal_error", "dl-error.c", "ld-linux", NULL) ||
-        call_match(function_name, source_file, "error_dialog_response_cb", "", NULL) ||
-        call_match(function_name, source_file, "do_warn", "_warnings.c", "libpython",NULL) ||
-        call_match(function_name, source_file, "QMessageLogger::fatal(char const*, ...) const", "", NULL) ||
-        call_match(function_name, source_file, "nsProfileLock::FatalSignalHandler(int, siginfo_t*, void*)", "", NULL) ||
-        call_match(function_name, source_file, "qt_message_output", "qglobal.cpp", "libQtCore", NULL) ||
-        call_match(function_name, source_file, "qt_message_output(QtMsgType, char const*)", "", NULL) ||
-        call_match(function_name, source_file, "signalHandler(int, siginfo_t*, void*)", "", NULL) ||
-        call_match(function_name, source_file, "FatalSignalHandler", "nsProfileLock.cpp", "libxul", NULL) ||
-        call_match(function_name, source_file, "Foam::error::abort()", "", NULL) ||
-        call_match(function_name, source_file, "JS_AbortIfWrongThread", "libmozjs", NULL) ||
-        call_match(function_name, source_file, "Crash::defaultCrashHandler(int)", "libkdeui", "libKF5Crash", NULL) ||
-        call_match(function_name, source_file, "Py_FatalError", "pythonrun.c", "libpython", NULL) ||
-        call_match(function_name, source_file, "__btrfs_abort_transaction", "btrfs", NULL) ||
-        call_match(function_name, source_file, "assert_pch_hdmi_disabled", "", NULL) ||
-        call_match(function_name, source_file, "assert_pll", "", NULL) ||
-        call_match(function_name, source_file, "core::system::abort()", "", NULL) ||
-        call_match(function_name, source_file, "ddd_assert_fail", "assert.C", NULL) ||
-        call_match(function_name, source_file, "debug_dma_assert_idle", "", NULL) ||
-        call_match(function_name, source_file, "error_handler", "", NULL) ||
-        call_match(function_name, source_file, "fatal_error_signal", "", NULL) ||
-        call_match(function_name, source_file, "fatal_handler", "signal.c", "libfreerdp", NULL) ||
-        call_match(function_name, source_file, "gpf_notice", "", NULL) ||
-        call_match(function_name, source_file, "log", "", NULL) ||
-        call_match(function_name, source_file, "_log", "", NULL) ||
-        call_match(function_name, source_file, "log_assert_failed", "", NULL) ||
-        call_match(function_name, source_file, "mozalloc_abort", "mozalloc_abort.cpp", "libmozalloc", NULL) ||
-        call_match(function_name, source_file, "mozalloc_abort(char const*)", "libmozalloc", "content-container", "plugin-container", NULL) ||
-        call_match(function_name, source_file, "note_interrupt", "spurious.c", "vmlinux", NULL) ||
-        call_match(function_name, source_file, "print_bad_pte", "memory.c", "vmlinux", NULL) ||
-        call_match(function_name, source_file, "print_oops_end_marker", "panic.c", "vmlinux", NULL) ||
-        call_match(function_name, source_file, "printk", "printk.c", "vmlinux", NULL) ||
-        call_match(function_name, source_file, "qupzilla_signal_handler", "main.cpp", "qupzilla", NULL) ||
-        call_match(function_name, source_file, "rb_bug", "error.c", "libruby", NULL) ||
-        call_match(function_name, source_file, "sighandler", "", NULL) ||
-        call_match(function_name, source_file, "signalHandler(int)", "", NULL) ||
-        call_match(function_name, source_file, "signal_abort", "signal.c", NULL) ||
-        call_match(function_name, source_file, "signal_handler", "", NULL) ||
-        call_match(function_name, source_file, "sys_abort", "error.c", "libgfortran", NULL) ||
-        call_match(function_name, source_file, "terminate_due_to_signal", "emacs.c", "emacs", NULL) ||
-        call_match(function_name, source_file, "wl_log", "wayland-util.c", NULL) ||
-        call_match(function_name, source_file, "display_protocol_error", "wayland-client.c", NULL) ||
-        call_match(function_name, source_file, "display_handle_error", "wayland-client.c", NULL) ||
-        call_match(function_name, source_file, "x_io_error", "libmutter", NULL) ||
-        call_match(function_name, source_file, "__ioremap_calle ", "ioremap.c", NULL) ||
-        call_match(function_name, source_file, "ioremap_nocache", "ioremap.c", NULL) ||
-        call_match(function_name, source_file, "wpa_msg", "wpa_debug.c", NULL) ||
-        call_match(function_name, source_file, "js::gc::FinalizeArenas(js::FreeOp*, js::gc::ArenaHeader**, js::gc::ArenaList&, js::gc::AllocKind, js::SliceBudget&)\"js::Shape::finalize(js::FreeOp*)", "", NULL) ||
-        call_match(function_name, source_file, "WTF::StringImpl::endsWith(char const*, unsigned int, bool) const", "", NULL) ||
-        call_match(function_name, source_file, "mozilla::plugins::child::_invokedefault(_NPP*, NPObject*, _NPVariant const*, unsigned int, _NPVariant*)", "", NULL) ||
-        call_match(function_name, source_file, "xitk_signal_handler", "xitk.c", "xine", NULL);
-}
+    if (count < 2 || rule->fields[1][0] == '\0')
+    {
+        *error_message = sr_asprintf("%s:%u: Missing function name",
+                                     filename, line_number);
+        return false;
+    }
 
-static bool
-is_removable_glibc_with_above(const char *function_name,
-                              const char *source_file)
-{
-    return
-        call_match(function_name, source_file, "__assert_fail", "", NULL) ||
-        call_match(function_name, source_file, "__assert_fail_base", "", NULL) ||
-        call_match(function_name, source_file, "__chk_fail", "", NULL) ||
-        call_match(function_name, source_file, "__longjmp_chk", "", NULL) ||
-        call_match(function_name, source_file, "__malloc_assert", "", NULL) ||
-        call_match(function_name, source_file, "__strcat_chk", "", NULL) ||
-        call_match(function_name, source_file, "__strcpy_chk", "", NULL) ||
-        call_match(function_name, source_file, "__strncpy_chk", "", NULL) ||
-        call_match(function_name, source_file, "__vsnprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "___vsnprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "__snprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "___snprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "__vasprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "__vsprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "___sprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "__fwprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "__asprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "___printf_chk", "", NULL) ||
-        call_match(function_name, source_file, "___fprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "__vswprintf_chk", "", NULL) ||
-        call_match(function_name, source_file, "malloc_consolidate", "malloc.c", "libc", NULL) ||
-        call_match(function_name, source_file, "malloc_printerr", "malloc.c", "libc", NULL) ||
-        call_match(function_name, source_file, "_int_malloc", "malloc.c", "libc", NULL) ||
-        call_match(function_name, source_file, "_int_free", "malloc.c", "libc", NULL) ||
-        call_match(function_name, source_file, "_int_realloc", "malloc.c", "libc", NULL) ||
-        call_match(function_name, source_file, "_int_memalign", "malloc.c", NULL) ||
-        call_match(function_name, source_file, "__libc_free", "malloc.c", NULL) ||
-        call_match(function_name, source_file, "__libc_malloc", "malloc.c", NULL) ||
-        call_match(function_name, source_file, "__libc_memalign", "malloc.c", NULL) ||
-        call_match(function_name, source_file, "__libc_realloc", "malloc.c", NULL) ||
-        call_match(function_name, source_file, "__posix_memalign", "malloc.c", NULL) ||
-        call_match(function_name, source_file, "__libc_calloc", "malloc.c", NULL) ||
-        call_match(function_name, source_file, "__libc_fatal", "libc", NULL);
+    if (rule->kind == RULE_RENAME && (count < 3 || rule->fields[2][0] == '\0'))
+    {
+        *error_message = sr_asprintf("%s:%u: Missing new function name",
+                                     filename, line_number);
+        return false;
+    }
+
+    rule->function_name = rule->fields[1];
+    rule->new_function_name = (rule->kind == RULE_RENAME
+                               ? rule->fields[2] : NULL);
+    rule->first_file = first_file;
+    rule->count = count;
+    return true;
 }
 
-static char *
-find_new_function_name_glibc(const char *function_name,
-                             const char *source_file)
-{
-    /* Normalize frame names. */
-#define NORMALIZE_ARCH_SPECIFIC(func)                                   \
-    if (call_match(function_name, source_file, "__" func "_sse2", func, "/sysdeps/", "libc.so", NULL) || \
-        call_match(function_name, source_file, "__" func "_sse2_bsf", func, "/sysdeps/", "libc.so", NULL) || \
-        call_match(function_name, source_file, "__" func "_ssse3", func, "/sysdeps/", "libc.so", NULL) /* ssse3, not sse3! */ || \
-        call_match(function_name, source_file, "__" func "_ssse3_rep", func, "/sysdeps/", "libc.so", NULL) || \
-        call_match(function_name, source_file, "__" func "_ssse3_back", func, "/sysdeps/", "libc.so", NULL) || \
-        call_match(function_name, source_file, "__" func "_sse42", func, "/sysdeps/", "libc.so", NULL) || \
-        call_match(function_name, source_file, "__" func "_ia32", func, "/sysdeps", "libc.so", NULL)) \
-        {                                                               \
-            return sr_strdup(func);                                     \
+bool
+sr_normalize_load_rules(const char *filename,
+                        char **error_message)
+{
+    char *contents = sr_file_to_string(filename, error_message);
+    if (!contents)
+        return false;
+
+    /* The whole file is parsed before any rule is added, so that a
+     * malformed line leaves the rules unchanged. */
+    struct parsed_rule *rules = NULL;
+    size_t rule_count = 0, allocated = 0;
+    bool success = true;
+    unsigned line_number = 0;
+    char *next_line = contents;
+    while (next_line)
+    {
+        char *line = next_line;
+        next_line = strchr(line, '\n');
+        if (next_line)
+            *next_line++ = '\0';
+
+        ++line_number;
+        if (line[0] == '\0' || line[0] == '#')
+            continue;
+
+        if (rule_count == allocated)
+        {
+            allocated = (allocated ? 2 * allocated : 16);
+            rules = sr_realloc_array(rules, allocated, sizeof(*rules));
         }
 
-        NORMALIZE_ARCH_SPECIFIC("memchr");
-        NORMALIZE_ARCH_SPECIFIC("memcmp");
-        NORMALIZE_ARCH_SPECIFIC("memcpy");
-        NORMALIZE_ARCH_SPECIFIC("memmove");
-        NORMALIZE_ARCH_SPECIFIC("memset");
-        NORMALIZE_ARCH_SPECIFIC("rawmemchr");
-        NORMALIZE_ARCH_SPECIFIC("strcasecmp");
-        NORMALIZE_ARCH_SPECIFIC("strcasecmp_l");
-        NORMALIZE_ARCH_SPECIFIC("strcat");
-        NORMALIZE_ARCH_SPECIFIC("strchr");
-        NORMALIZE_ARCH_SPECIFIC("strchrnul");
-        NORMALIZE_ARCH_SPECIFIC("strcmp");
-        NORMALIZE_ARCH_SPECIFIC("strcpy");
-        NORMALIZE_ARCH_SPECIFIC("strcspn");
-        NORMALIZE_ARCH_SPECIFIC("strlen");
-        NORMALIZE_ARCH_SPECIFIC("strncmp");
-        NORMALIZE_ARCH_SPECIFIC("strncpy");
-        NORMALIZE_ARCH_SPECIFIC("strpbrk");
-        NORMALIZE_ARCH_SPECIFIC("strrchr");
-        NORMALIZE_ARCH_SPECIFIC("strspn");
-        NORMALIZE_ARCH_SPECIFIC("strstr");
-        NORMALIZE_ARCH_SPECIFIC("strtok");
-        return NULL;
+        if (!parse_rule_line(line, filename, line_number, &rules[rule_count],
+                             error_message))
+        {
+            success = false;
+            break;
+        }
+
+        ++rule_count;
+    }
+
+    if (success)
+    {
+        pthread_once(&compiled_rules_once, compile_builtin_rules);
+        pthread_rwlock_wrlock(&compiled_rules_lock);
+
+        /* Without source files the rule matches every known one. */
+        static const char *const any_source_file[] = { "" };
+        for (struct parsed_rule *rule = rules; rule < rules + rule_count;
+             ++rule)
+        {
+            if (rule->count > rule->first_file)
+            {
+                add_rule(rule->kind, rule->function_name,
+                         rule->fields + rule->first_file,
+                         rule->count - rule->first_file,
+                         rule->new_function_name);
+            }
+            else
+            {
+                add_rule(rule->kind, rule->function_name, any_source_file, 1,
+                         rule->new_function_name);
+            }
+        }
+
+        pthread_rwlock_unlock(&compiled_rules_lock);
+    }
+
+    free(rules);
+    free(contents);
+    return success;
 }
 
 static void
@@ -375,109 +702,123 @@ remove_func_prefix(char *function_name, const char *prefix, int num)
     memmove(function_name, function_name + num, func_len - num + 1);
 }
 
+/* Must be called with the lock held. */
 static bool
-sr_gdb_is_exit_frame(struct sr_gdb_frame *frame)
-{
-    return
-        sr_gdb_frame_calls_func(frame, "__run_exit_handlers", "exit.c", NULL) ||
-        sr_gdb_frame_calls_func(frame, "raise", "pt-raise.c", "libc.so", "libc-", "libpthread.so", NULL) ||
-        sr_gdb_frame_calls_func(frame, "__GI_raise", "raise.c", NULL) ||
-        sr_gdb_frame_calls_func(frame, "exit", "exit.c", NULL) ||
-        sr_gdb_frame_calls_func(frame, "abort", "abort.c", "libc.so", "libc-", NULL) ||
-        sr_gdb_frame_calls_func(frame, "__GI_abort", "abort.c", NULL) ||
-        /* Terminates a function in case of buffer overflow. */
-        sr_gdb_frame_calls_func(frame, "__chk_fail", "chk_fail.c", "libc.so", NULL) ||
-        sr_gdb_frame_calls_func(frame, "__stack_chk_fail", "stack_chk_fail.c", "libc.so", NULL) ||
-        sr_gdb_frame_calls_func(frame, "do_exit", "exit.c", NULL) ||
-        sr_gdb_frame_calls_func(frame, "kill", "syscall-template.S", NULL);
+gdb_is_exit_frame(struct sr_gdb_frame *frame)
+{
+    return find_rule(frame->function_name, frame->source_file,
+                     RULE_GDB_EXIT);
 }
 
-void
-sr_normalize_gdb_thread(struct sr_gdb_thread *thread)
+/* Must be called with the lock held. */
+static bool
+core_is_exit_frame(struct sr_core_frame *frame)
+{
+    return find_rule(frame->function_name, frame->file_name,
+                     RULE_CORE_EXIT);
+}
+
+static void
+gdb_frames_free(struct sr_gdb_frame *frame)
 {
-    /* Find the exit frame and remove everything above it. */
-    struct sr_gdb_frame *exit_frame = sr_glibc_thread_find_exit_frame(thread);
-    if (exit_frame)
+    while (frame)
     {
-        bool success = sr_gdb_thread_remove_frames_above(thread, exit_frame);
-        assert(success); /* if this fails, some code become broken */
-        success = sr_gdb_thread_remove_frame(thread, exit_frame);
-        assert(success); /* if this fails, some code become broken */
+        struct sr_gdb_frame *next_frame = frame->next;
+        sr_gdb_frame_free(frame);
+        frame = next_frame;
     }
+}
 
-    /* Normalize function names by removing various prefixes that
-     * occur only in some cases.
-     */
-    struct sr_gdb_frame *frame = thread->frames;
+static void
+core_frames_free(struct sr_core_frame *frame)
+{
     while (frame)
     {
-        if (frame->source_file)
-        {
-            /* Remove IA__ prefix used in GLib, GTK and GDK. */
-            remove_func_prefix(frame->function_name, "IA__gdk", strlen("IA__"));
-            remove_func_prefix(frame->function_name, "IA__g_", strlen("IA__"));
-            remove_func_prefix(frame->function_name, "IA__gtk", strlen("IA__"));
-
-            /* Remove __GI_ (glibc internal) prefix. */
-            remove_func_prefix(frame->function_name, "__GI_", strlen("__GI_"));
-        }
-
-        frame = frame->next;
+        struct sr_core_frame *next_frame = frame->next;
+        sr_core_frame_free(frame);
+        frame = next_frame;
     }
+}
+
+void
+sr_normalize_gdb_thread(struct sr_gdb_thread *thread)
+{
+    lock_rules();
 
-    /* Unify some functions by renaming them.
+    /* Normalize and filter the frames in a single pass.  The kept frames
+     * are linked through *tail, so removing a frame does not rescan the
+     * thread, and removing the frames above a frame releases everything
+     * kept so far.
      */
-    frame = thread->frames;
+    struct sr_gdb_frame *frame = thread->frames;
+    struct sr_gdb_frame **tail = &thread->frames;
     while (frame)
     {
-        char *new_function_name =
-            find_new_function_name_glibc(frame->function_name, frame->source_file);
+        struct sr_gdb_frame *next_frame = frame->next;
+        bool removable = false;
+        bool removable_with_above;
 
-        if (new_function_name)
+        /* Remove the exit frames and everything above them. */
+        if (gdb_is_exit_frame(frame))
+            removable_with_above = true;
+        else
         {
-            free(frame->function_name);
-            frame->function_name = new_function_name;
-        }
+            /* Normalize function names by removing various prefixes
+             * that occur only in some cases.
+             */
+            if (frame->source_file)
+            {
+                /* Remove IA__ prefix used in GLib, GTK and GDK. */
+                remove_func_prefix(frame->function_name, "IA__gdk", strlen("IA__"));
+                remove_func_prefix(frame->function_name, "IA__g_", strlen("IA__"));
+                remove_func_prefix(frame->function_name, "IA__gtk", strlen("IA__"));
 
-        frame = frame->next;
-    }
+                /* Remove __GI_ (glibc internal) prefix. */
+                remove_func_prefix(frame->function_name, "__GI_", strlen("__GI_"));
+            }
 
-    /* Remove redundant frames from the thread.
-     */
-    frame = thread->frames;
-    while (frame)
-    {
-        struct sr_gdb_frame *next_frame = frame->next;
+            /* Unify some functions by renaming them. */
+            char *new_function_name =
+                find_new_function_name(frame->function_name, frame->source_file);
 
-        /* Remove frames which are not a cause of the crash. */
-        bool removable =
-            is_removable_dbus(frame->function_name, frame->source_file) ||
-            is_removable_gdk(frame->function_name, frame->source_file) ||
-            is_removable_glib(frame->function_name, frame->source_file) ||
-            is_removable_glibc(frame->function_name, frame->source_file) ||
-            is_removable_libstdcpp(frame->function_name, frame->source_file) ||
-            is_removable_linux(frame->function_name, frame->source_file) ||
-            is_removable_xorg(frame->function_name, frame->source_file) ||
-            is_removable_jvm(frame->function_name, frame->source_file) ||
-            is_removable_vim(frame->function_name, frame->source_file) ||
-            is_removable_other(frame->function_name, frame->source_file);
-
-        bool removable_with_above =
-            is_removable_glibc_with_above(frame->function_name, frame->source_file) ||
-            sr_gdb_is_exit_frame(frame);
+            if (new_function_name)
+            {
+                free(frame->function_name);
+                frame->function_name = new_function_name;
+            }
+
+            /* Remove frames which are not a cause of the crash. */
+            removable =
+                find_rule(frame->function_name, frame->source_file, RULE_REMOVE);
+
+            removable_with_above =
+                find_rule(frame->function_name, frame->source_file,
+                          RULE_REMOVE_WITH_ABOVE) ||
+                gdb_is_exit_frame(frame);
+        }
 
         if (removable_with_above)
         {
-            bool success = sr_gdb_thread_remove_frames_above(thread, frame);
-            assert(success);
+            *tail = NULL;
+            gdb_frames_free(thread->frames);
+            thread->frames = NULL;
+            tail = &thread->frames;
         }
 
         if (removable || removable_with_above)
-            sr_gdb_thread_remove_frame(thread, frame);
+            sr_gdb_frame_free(frame);
+        else
+        {
+            *tail = frame;
+            tail = &frame->next;
+        }
 
         frame = next_frame;
     }
 
+    *tail = NULL;
+    unlock_rules();
+
     /* If the first frame has address 0x0000 and its name is '??', it
      * is a dereferenced null, and we remove it. This frame is not
      * really invalid, but it affects stacktrace quality rating. See
@@ -542,89 +883,79 @@ sr_normalize_gdb_thread(struct sr_gdb_thread *thread)
 void
 sr_normalize_core_thread(struct sr_core_thread *thread)
 {
-    /* Find the exit frame and remove everything above it. */
-    struct sr_core_frame *exit_frame = sr_core_thread_find_exit_frame(thread);
-    if (exit_frame)
-    {
-        bool success = sr_thread_remove_frames_above((struct sr_thread *)thread,
-                                                     (struct sr_frame *)exit_frame);
-        assert(success); /* if this fails, some code become broken */
-        success = sr_thread_remove_frame((struct sr_thread *)thread,
-                                         (struct sr_frame *)exit_frame);
-        assert(success); /* if this fails, some code become broken */
-    }
+    lock_rules();
 
-    /* Normalize function names by removing various prefixes that
-     * occur only in some cases.
+    /* Normalize and filter the frames in a single pass.  The kept frames
+     * are linked through *tail, so removing a frame does not rescan the
+     * thread, and removing the frames above a frame releases everything
+     * kept so far.
      */
     struct sr_core_frame *frame = thread->frames;
+    struct sr_core_frame **tail = &thread->frames;
     while (frame)
     {
-        /* Remove IA__ prefix used in GLib, GTK and GDK. */
-        remove_func_prefix(frame->function_name, "IA__gdk", strlen("IA__"));
-        remove_func_prefix(frame->function_name, "IA__g_", strlen("IA__"));
-        remove_func_prefix(frame->function_name, "IA__gtk", strlen("IA__"));
-
-        /* Remove __GI_ (glibc internal) prefix. */
-        remove_func_prefix(frame->function_name, "__GI_", strlen("__GI_"));
+        struct sr_core_frame *next_frame = frame->next;
+        bool removable = false;
+        bool removable_with_above;
 
-        frame = frame->next;
-    }
+        /* Remove the exit frames and everything above them. */
+        if (core_is_exit_frame(frame))
+            removable_with_above = true;
+        else
+        {
+            /* Normalize function names by removing various prefixes
+             * that occur only in some cases.
+             */
+            /* Remove IA__ prefix used in GLib, GTK and GDK. */
+            remove_func_prefix(frame->function_name, "IA__gdk", strlen("IA__"));
+            remove_func_prefix(frame->function_name, "IA__g_", strlen("IA__"));
+            remove_func_prefix(frame->function_name, "IA__gtk", strlen("IA__"));
 
-    /* Unify some functions by renaming them.
-     */
-    frame = thread->frames;
-    while (frame)
-    {
-        char *new_function_name =
-            find_new_function_name_glibc(frame->function_name, frame->file_name);
+            /* Remove __GI_ (glibc internal) prefix. */
+            remove_func_prefix(frame->function_name, "__GI_", strlen("__GI_"));
 
-        if (new_function_name)
-        {
-            free(frame->function_name);
-            frame->function_name = new_function_name;
-        }
+            /* Unify some functions by renaming them. */
+            char *new_function_name =
+                find_new_function_name(frame->function_name, frame->file_name);
 
-        frame = frame->next;
-    }
+            if (new_function_name)
+            {
+                free(frame->function_name);
+                frame->function_name = new_function_name;
+            }
 
-    /* Remove redundant frames from the thread.
-     */
-    frame = thread->frames;
-    while (frame)
-    {
-        struct sr_core_frame *next_frame = frame->next;
+            /* Remove frames which are not a cause of the crash. */
+            removable =
+                find_rule(frame->function_name, frame->file_name, RULE_REMOVE);
 
-        /* Remove frames which are not a cause of the crash. */
-        bool removable =
-            is_removable_dbus(frame->function_name, frame->file_name) ||
-            is_removable_gdk(frame->function_name, frame->file_name) ||
-            is_removable_glib(frame->function_name, frame->file_name) ||
-            is_removable_glibc(frame->function_name, frame->file_name) ||
-            is_removable_libstdcpp(frame->function_name, frame->file_name) ||
-            is_removable_linux(frame->function_name, frame->file_name) ||
-            is_removable_xorg(frame->function_name, frame->file_name) ||
-            is_removable_jvm(frame->function_name, frame->file_name) ||
-            is_removable_vim(frame->function_name, frame->file_name) ||
-            is_removable_other(frame->function_name, frame->file_name);
-
-        bool removable_with_above =
-            is_removable_glibc_with_above(frame->function_name, frame->file_name)  ||
-            sr_core_thread_is_exit_frame(frame);
+            removable_with_above =
+                find_rule(frame->function_name, frame->file_name,
+                          RULE_REMOVE_WITH_ABOVE) ||
+                core_is_exit_frame(frame);
+        }
 
         if (removable_with_above)
         {
-            bool success = sr_thread_remove_frames_above((struct sr_thread *)thread,
-                                                         (struct sr_frame *)frame);
-            assert(success);
+            *tail = NULL;
+            core_frames_free(thread->frames);
+            thread->frames = NULL;
+            tail = &thread->frames;
         }
 
         if (removable || removable_with_above)
-            sr_thread_remove_frame((struct sr_thread *)thread, (struct sr_frame *)frame);
+            sr_core_frame_free(frame);
+        else
+        {
+            *tail = frame;
+            tail = &frame->next;
+        }
 
         frame = next_frame;
     }
 
+    *tail = NULL;
+    unlock_rules();
+
     /* If the first frame has address 0x0000 and its name is '??', it
      * is a dereferenced null, and we remove it. This frame is not
      * really invalid, but it affects stacktrace quality rating. See
@@ -799,15 +1130,46 @@ sr_gdb_normalize_optimize_thread(struct sr_gdb_thread *thread)
 struct sr_gdb_frame *
 sr_glibc_thread_find_exit_frame(struct sr_gdb_thread *thread)
 {
+    lock_rules();
+
     struct sr_gdb_frame *frame = thread->frames;
     struct sr_gdb_frame *result = NULL;
     while (frame)
     {
-        if (sr_gdb_is_exit_frame(frame))
+        if (gdb_is_exit_frame(frame))
+            result = frame;
+
+        frame = frame->next;
+    }
+
+    unlock_rules();
+    return result;
+}
+
+bool
+sr_core_thread_is_exit_frame(struct sr_core_frame *frame)
+{
+    lock_rules();
+    bool result = core_is_exit_frame(frame);
+    unlock_rules();
+    return result;
+}
+
+struct sr_core_frame *
+sr_core_thread_find_exit_frame(struct sr_core_thread *thread)
+{
+    lock_rules();
+
+    struct sr_core_frame *frame = thread->frames;
+    struct sr_core_frame *result = NULL;
+    while (frame)
+    {
+        if (core_is_exit_frame(frame))
             result = frame;
 
         frame = frame->next;
     }
 
+    unlock_rules();
     return result;
 }
@@ -23,6 +23,7 @@
 #include "strbuf.h"
 #include "config.h"
 #include "internal_utils.h"
+#include "hash_table.h"
 #include <errno.h>
 #ifdef HAVE_LIBRPM
 #include <rpm/rpmlib.h>
@@ -33,6 +34,7 @@
 #endif
 #include <fcntl.h>
 #include <assert.h>
+#include <pthread.h>
 #include <string.h>
 
 struct sr_rpm_package *
@@ -204,73 +206,219 @@ sr_rpm_package_sort(struct sr_rpm_package *packages)
     return result;
 }
 
-static struct sr_rpm_package *
-package_merge(struct sr_rpm_package *p1, struct sr_rpm_package *p2)
+/* Packages with the same name, epoch, version and release.  Their
+ * architectures differ, except that one of them may be missing. */
+struct package_group
 {
-    if (0 != sr_rpm_package_cmp_nvr(p1, p2))
-        return NULL;
+    struct sr_rpm_package *first;
+    struct sr_rpm_package *last;
+};
+
+/* The name, epoch, version and release of a package with their hash
+ * computed once, so that sort_uniq hashes every package only once.  The
+ * architecture is left out, because a missing architecture matches any
+ * other when merging. */
+struct nevra_key
+{
+    size_t hash;
+    struct sr_rpm_package *package;
+};
+
+static void
+nevra_key_init(struct nevra_key *key, struct sr_rpm_package *package)
+{
+    size_t hash = (package->name ? hash_string(package->name) : 0);
+    hash = hash * 31 + (package->version ? hash_string(package->version) : 0);
+    hash = hash * 31 + (package->release ? hash_string(package->release) : 0);
+    key->hash = hash * 31 + package->epoch;
+    key->package = package;
+}
+
+static size_t
+nevra_key_hash(const void *key)
+{
+    return ((const struct nevra_key *)key)->hash;
+}
 
+static bool
+nevra_key_equal(const void *key1, const void *key2)
+{
+    const struct nevra_key *k1 = key1, *k2 = key2;
+    return k1->hash == k2->hash
+        && k1->package->epoch == k2->package->epoch
+        && 0 == sr_rpm_package_cmp_nvr(k1->package, k2->package);
+}
+
+/* Packages can be merged if they only differ in one of them missing the
+ * architecture.  Neighbours usually differ early in the name, so the
+ * strings are compared directly. */
+static bool
+packages_mergeable(struct sr_rpm_package *p1, struct sr_rpm_package *p2)
+{
     if (p1->epoch != p2->epoch)
-        return NULL;
+        return false;
 
     if (p1->architecture && p2->architecture &&
-        0 != sr_strcmp0(p1->architecture, p2->architecture))
-        return NULL;
+        0 != strcmp(p1->architecture, p2->architecture))
+    {
+        return false;
+    }
+
+    return 0 == sr_rpm_package_cmp_nvr(p1, p2);
+}
+
+/* Merges p2 into p1 and releases p2.  The values of p1 take
+ * precedence. */
+static void
+package_merge_into(struct sr_rpm_package *p1, struct sr_rpm_package *p2)
+{
+    if (!p1->architecture)
+    {
+        p1->architecture = p2->architecture;
+        p2->architecture = NULL;
+    }
 
-    struct sr_rpm_package *merged = sr_rpm_package_new();
-    merged->name = sr_strdup(p1->name);
-    merged->epoch = p1->epoch;
-    merged->version = sr_strdup(p1->version);
-    merged->release = sr_strdup(p1->release);
+    if (!p1->install_time)
+        p1->install_time = p2->install_time;
 
-    /* architecture is sometimes missing */
-    if (p1->architecture)
-        merged->architecture = sr_strdup(p1->architecture);
-    else if (p2->architecture)
-        merged->architecture = sr_strdup(p2->architecture);
+    if (!p1->role)
+        p1->role = p2->role;
 
-    merged->install_time = (p1->install_time ?
-                            p1->install_time : p2->install_time);
+    /* A merged package does not keep the consistency information. */
+    sr_rpm_consistency_free(p1->consistency, true);
+    p1->consistency = NULL;
+    sr_rpm_package_free(p2, false);
+}
 
-    merged->role = (p1->role ? p1->role : p2->role);
+static void
+package_group_append(struct package_group *group,
+                     struct sr_rpm_package *package)
+{
+    struct sr_rpm_package *loop;
+    for (loop = group->first; loop; loop = loop->next)
+    {
+        if (0 == sr_strcmp0(loop->architecture, package->architecture))
+        {
+            package_merge_into(loop, package);
+            return;
+        }
+    }
 
-    return merged;
+    package->next = NULL;
+    group->last->next = package;
+    group->last = package;
 }
 
 struct sr_rpm_package *
 sr_rpm_package_uniq(struct sr_rpm_package *packages)
 {
-    struct sr_rpm_package *loop = packages, *prev = NULL;
-    while (loop && loop->next)
+    if (!packages)
+        return NULL;
+
+    struct sr_rpm_package *loop = packages;
+    while (loop->next)
     {
-        struct sr_rpm_package *merged = package_merge(loop, loop->next);
-        if (merged)
+        if (packages_mergeable(loop, loop->next))
         {
-            /* deleted record is not the first in list */
-            if (prev)
-            {
-                prev->next = merged;
-            }
-            /* deleting first record */
-            else
+            struct sr_rpm_package *next = loop->next;
+            loop->next = next->next;
+            package_merge_into(loop, next);
+        }
+        else
+            loop = loop->next;
+    }
+
+    return packages;
+}
+
+struct sr_rpm_package *
+sr_rpm_package_sort_uniq(struct sr_rpm_package *packages)
+{
+    if (!packages)
+        return NULL;
+
+    size_t count = sr_rpm_package_count(packages);
+    struct nevra_key *keys = sr_malloc_array(count, sizeof(*keys));
+
+    /* The groups are kept in an array, the table maps the key of their
+     * first package to the index. */
+    struct hash_table *table = hash_table_new(nevra_key_hash,
+                                              nevra_key_equal,
+                                              NULL, NULL);
+    size_t group_count = 0;
+    struct package_group *groups = sr_malloc_array(count, sizeof(*groups));
+    struct sr_rpm_package *package = packages;
+    for (size_t i = 0; i < count; ++i)
+    {
+        struct sr_rpm_package *next = package->next;
+        nevra_key_init(&keys[i], package);
+
+        void *value;
+        if (hash_table_lookup(table, &keys[i], &value))
+            package_group_append(&groups[(uintptr_t)value], package);
+        else
+        {
+            package->next = NULL;
+            groups[group_count].first = groups[group_count].last = package;
+            hash_table_insert(table, &keys[i], (void *)(uintptr_t)group_count);
+            ++group_count;
+        }
+
+        package = next;
+    }
+
+    hash_table_free(table);
+    free(keys);
+
+    /* Collect the distinct packages.  After sorting, a package without
+     * architecture would precede the others of its group and be merged
+     * with the first one of them, so it is merged in the same way. */
+    struct sr_rpm_package **array = sr_malloc_array(count, sizeof(*array));
+    size_t distinct = 0;
+    for (size_t i = 0; i < group_count; ++i)
+    {
+        struct sr_rpm_package *no_architecture = NULL, *first = NULL;
+        for (package = groups[i].first; package; package = package->next)
+        {
+            if (!package->architecture)
+                no_architecture = package;
+            else if (!first || sr_strcmp0(package->architecture,
+                                          first->architecture) < 0)
+                first = package;
+        }
+
+        struct sr_rpm_package *next;
+        for (package = groups[i].first; package; package = next)
+        {
+            next = package->next;
+            if (no_architecture && first
+                && (package == no_architecture || package == first))
             {
-                packages = merged;
+                continue;
             }
-            merged->next = loop->next->next;
-
-            sr_rpm_package_free(loop->next, false);
-            sr_rpm_package_free(loop, false);
 
-            loop = merged;
+            array[distinct++] = package;
         }
-        else
+
+        if (no_architecture && first)
         {
-            prev = loop;
-            loop = loop->next;
+            package_merge_into(no_architecture, first);
+            array[distinct++] = no_architecture;
         }
     }
 
-    return packages;
+    free(groups);
+
+    qsort(array, distinct, sizeof(*array),
+          (comparison_fn_t)cmp_nevra_qsort_wrapper);
+
+    for (size_t i = 0; i + 1 < distinct; ++i)
+        array[i]->next = array[i + 1];
+
+    array[distinct - 1]->next = NULL;
+    struct sr_rpm_package *result = array[0];
+    free(array);
+    return result;
 }
 
 #ifdef HAVE_LIBRPM
@@ -376,27 +524,36 @@ header_to_rpm_info(Header header,
 }
 #endif
 
-/**
- * Takes 0.06 second for bash package consisting of 92 files.
- * Takes 0.75 second for emacs-common package consisting of 2585 files.
- */
-struct sr_rpm_package *
-sr_rpm_package_get_by_name(const char *name, char **error_message)
-{
 #ifdef HAVE_LIBRPM
-    if (rpmReadConfigFiles(NULL, NULL))
+static pthread_once_t rpm_config_once = PTHREAD_ONCE_INIT;
+static int rpm_config_result;
+
+static void
+rpm_config_read(void)
+{
+    rpm_config_result = rpmReadConfigFiles(NULL, NULL);
+}
+
+/* Reading the configuration is expensive and its result is global, so
+ * it is only done once per process. */
+static rpmts
+rpm_ts_new(char **error_message)
+{
+    pthread_once(&rpm_config_once, rpm_config_read);
+    if (rpm_config_result)
     {
         *error_message = sr_asprintf("Failed to read RPM configuration files.");
         return NULL;
     }
 
-    rpmts ts = rpmtsCreate();
-    rpmdbMatchIterator iter = rpmtsInitIterator(ts,
-                                                RPMTAG_NAME,
-                                                name,
-                                                strlen(name));
+    return rpmtsCreate();
+}
 
-    struct sr_rpm_package *result = NULL;
+static struct sr_rpm_package *
+rpm_packages_from_iterator(rpmdbMatchIterator iter,
+                           char **error_message)
+{
+    struct sr_rpm_package *result = NULL, **tail = &result;
     Header header;
     while ((header = rpmdbNextIterator(iter)))
     {
@@ -409,9 +566,34 @@ sr_rpm_package_get_by_name(const char *name, char **error_message)
             break;
         }
 
-        result = sr_rpm_package_append(result, package);
+        *tail = package;
+        tail = &package->next;
     }
 
+    return result;
+}
+#endif
+
+/**
+ * Takes 0.06 second for bash package consisting of 92 files.
+ * Takes 0.75 second for emacs-common package consisting of 2585 files.
+ */
+struct sr_rpm_package *
+sr_rpm_package_get_by_name(const char *name, char **error_message)
+{
+#ifdef HAVE_LIBRPM
+    rpmts ts = rpm_ts_new(error_message);
+    if (!ts)
+        return NULL;
+
+    rpmdbMatchIterator iter = rpmtsInitIterator(ts,
+                                                RPMTAG_NAME,
+                                                name,
+                                                strlen(name));
+
+    struct sr_rpm_package *result = rpm_packages_from_iterator(iter,
+                                                               error_message);
+
     rpmdbFreeIterator(iter);
     rpmtsFree(ts);
     return result;
@@ -425,42 +607,208 @@ struct sr_rpm_package *
 sr_rpm_package_get_by_path(const char *path,
                            char **error_message)
 {
+    struct sr_rpm_db *db = sr_rpm_db_open(error_message);
+    if (!db)
+        return NULL;
+
+    struct sr_rpm_package *result = sr_rpm_db_get_by_path(db, path,
+                                                          error_message);
+
+    sr_rpm_db_free(db);
+    return result;
+}
+
+struct sr_rpm_db
+{
+    /* Lookups are serialized, the transaction set is not thread-safe. */
+    pthread_mutex_t lock;
+    /* Maps a path to the list of packages owning it, NULL if there is
+     * none. */
+    struct hash_table *path_cache;
+    sr_rpm_db_lookup_fn lookup;
+    void *lookup_data;
 #ifdef HAVE_LIBRPM
-    if (rpmReadConfigFiles(NULL, NULL))
+    rpmts ts;
+#endif
+};
+
+static void
+package_list_free(void *packages)
+{
+    sr_rpm_package_free(packages, true);
+}
+
+static struct sr_rpm_package *
+package_list_dup(struct sr_rpm_package *packages)
+{
+    struct sr_rpm_package *result = NULL, **tail = &result;
+    for (; packages; packages = packages->next)
     {
-        *error_message = sr_asprintf("Failed to read RPM configuration files.");
-        return NULL;
+        struct sr_rpm_package *copy = sr_rpm_package_new();
+        copy->name = sr_strdup(packages->name);
+        copy->epoch = packages->epoch;
+        copy->version = sr_strdup(packages->version);
+        copy->release = sr_strdup(packages->release);
+        copy->architecture = (packages->architecture
+                              ? sr_strdup(packages->architecture) : NULL);
+        copy->install_time = packages->install_time;
+        copy->role = packages->role;
+        *tail = copy;
+        tail = &copy->next;
     }
 
-    rpmts ts = rpmtsCreate();
-    rpmdbMatchIterator iter = rpmtsInitIterator(ts,
+    return result;
+}
+
+#ifdef HAVE_LIBRPM
+static struct sr_rpm_package *
+rpm_db_lookup_path(const char *path,
+                   void *data,
+                   char **error_message)
+{
+    struct sr_rpm_db *db = data;
+    rpmdbMatchIterator iter = rpmtsInitIterator(db->ts,
                                                 RPMTAG_BASENAMES,
                                                 path,
                                                 strlen(path));
 
+    struct sr_rpm_package *result = rpm_packages_from_iterator(iter,
+                                                               error_message);
+
+    rpmdbFreeIterator(iter);
+    return result;
+}
+#endif
+
+struct sr_rpm_db *
+sr_rpm_db_new_from_lookup(sr_rpm_db_lookup_fn lookup,
+                          void *data)
+{
+    struct sr_rpm_db *db = sr_mallocz(sizeof(*db));
+    pthread_mutex_init(&db->lock, NULL);
+    db->path_cache = hash_table_new(hash_string, string_equal,
+                                    free, package_list_free);
+    db->lookup = lookup;
+    db->lookup_data = data;
+    return db;
+}
+
+struct sr_rpm_db *
+sr_rpm_db_open(char **error_message)
+{
+#ifdef HAVE_LIBRPM
+    rpmts ts = rpm_ts_new(error_message);
+    if (!ts)
+        return NULL;
+
+    struct sr_rpm_db *db = sr_rpm_db_new_from_lookup(rpm_db_lookup_path, NULL);
+    db->lookup_data = db;
+    db->ts = ts;
+    return db;
+#else
+    *error_message = sr_asprintf("satyr compiled without rpm");
+    return NULL;
+#endif
+}
+
+void
+sr_rpm_db_free(struct sr_rpm_db *db)
+{
+    if (!db)
+        return;
+
+#ifdef HAVE_LIBRPM
+    if (db->ts)
+        rpmtsFree(db->ts);
+#endif
+
+    hash_table_free(db->path_cache);
+    pthread_mutex_destroy(&db->lock);
+    free(db);
+}
+
+/* Must be called with the lock held.  The result is owned by the cache. */
+static bool
+rpm_db_lookup_cached(struct sr_rpm_db *db,
+                     const char *path,
+                     struct sr_rpm_package **packages,
+                     char **error_message)
+{
+    void *cached;
+    if (hash_table_lookup(db->path_cache, path, &cached))
+    {
+        *packages = cached;
+        return true;
+    }
+
+    char *lookup_error = NULL;
+    struct sr_rpm_package *result = db->lookup(path, db->lookup_data,
+                                               &lookup_error);
+
+    /* Failed lookups are not cached, they may succeed next time. */
+    if (lookup_error)
+    {
+        sr_rpm_package_free(result, true);
+        *error_message = lookup_error;
+        return false;
+    }
+
+    hash_table_insert(db->path_cache, sr_strdup(path), result);
+    *packages = result;
+    return true;
+}
+
+struct sr_rpm_package *
+sr_rpm_db_get_by_path(struct sr_rpm_db *db,
+                      const char *path,
+                      char **error_message)
+{
     struct sr_rpm_package *result = NULL;
-    Header header;
-    while ((header = rpmdbNextIterator(iter)))
+    pthread_mutex_lock(&db->lock);
+
+    struct sr_rpm_package *cached;
+    if (rpm_db_lookup_cached(db, path, &cached, error_message))
+        result = package_list_dup(cached);
+
+    pthread_mutex_unlock(&db->lock);
+    return result;
+}
+
+bool
+sr_rpm_packages_get_by_paths(struct sr_rpm_db *db,
+                             const char *const *paths,
+                             size_t count,
+                             struct sr_rpm_package **packages,
+                             char **error_message)
+{
+    bool success = true;
+    size_t i;
+    pthread_mutex_lock(&db->lock);
+    for (i = 0; i < count; ++i)
     {
-        struct sr_rpm_package *package = header_to_rpm_info(header,
-                                                            error_message);
-        if (!package)
+        struct sr_rpm_package *cached;
+        if (!rpm_db_lookup_cached(db, paths[i], &cached, error_message))
         {
-            sr_rpm_package_free(result, true);
-            result = NULL;
+            success = false;
             break;
         }
 
-        result = sr_rpm_package_append(result, package);
+        packages[i] = package_list_dup(cached);
     }
 
-    rpmdbFreeIterator(iter);
-    rpmtsFree(ts);
-    return result;
-#else
-    *error_message = sr_asprintf("satyr compiled without rpm");
-    return NULL;
-#endif
+    pthread_mutex_unlock(&db->lock);
+
+    if (!success)
+    {
+        while (i > 0)
+        {
+            --i;
+            sr_rpm_package_free(packages[i], true);
+            packages[i] = NULL;
+        }
+    }
+
+    return success;
 }
 
 char *
@@ -697,15 +1045,29 @@ sr_rpm_package_parse_nevra(const char *text,
                            char **release,
                            char **architecture)
 {
-    char *last_dot = strrchr(text, '.');
-    if (!last_dot || 0 == strlen(last_dot))
+    return sr_rpm_package_parse_nevra_n(text, strlen(text), name, epoch,
+                                        version, release, architecture);
+}
+
+bool
+sr_rpm_package_parse_nevra_n(const char *text,
+                             size_t length,
+                             char **name,
+                             uint32_t *epoch,
+                             char **version,
+                             char **release,
+                             char **architecture)
+{
+    const char *end = text + length;
+    const char *last_dot = memrchr(text, '.', length);
+    if (!last_dot)
         return false;
 
-    char *last_dash = strrchr(text, '-');
+    const char *last_dash = memrchr(text, '-', length);
     if (!last_dash || last_dot - last_dash <= 1)
         return false;
 
-    char *last_but_one_dash = last_dash;
+    const char *last_but_one_dash = last_dash;
     while (last_but_one_dash > text)
     {
         --last_but_one_dash;
@@ -719,31 +1081,24 @@ sr_rpm_package_parse_nevra(const char *text,
         return false;
     }
 
-    char *colon = strchr(last_but_one_dash, ':');
-    if (colon && colon > last_dash)
-        colon = NULL;
-
+    const char *colon = memchr(last_but_one_dash, ':', last_dash - last_but_one_dash);
     if (colon && (last_dash - colon == 1 ||
                   colon - last_but_one_dash == 1))
     {
         return false;
     }
 
-    // Architecture is after the last dot.
-    *architecture = sr_strdup(last_dot + 1);
-
-    // Release is after the last dash.
-    *release = sr_strndup(last_dash + 1, last_dot - last_dash - 1);
-
     // Epoch is optional.
+    uint32_t parsed_epoch = 0;
     if (colon)
     {
-        // Version is before the last dash.
-        *version = sr_strndup(colon + 1,
-                              last_dash - colon - 1);
+        char epoch_str[32];
+        size_t epoch_length = colon - last_but_one_dash - 1;
+        if (epoch_length >= sizeof(epoch_str))
+            return false;
 
-        char *epoch_str = sr_strndup(last_but_one_dash + 1,
-                                     colon - last_but_one_dash - 1);
+        memcpy(epoch_str, last_but_one_dash + 1, epoch_length);
+        epoch_str[epoch_length] = '\0';
 
         char *endptr;
         errno = 0;
@@ -752,24 +1107,22 @@ sr_rpm_package_parse_nevra(const char *text,
                         || r > UINT32_MAX);
 
         if (failure)
-        {
-            free(epoch_str);
-            free(*release);
-            free(*architecture);
             return false;
-        }
 
-        *epoch = r;
-        free(epoch_str);
+        parsed_epoch = r;
     }
-    else
-    {
-        // Version is before the last dash.
-        *version = sr_strndup(last_but_one_dash + 1,
-                              last_dash - last_but_one_dash - 1);
 
-        *epoch = 0;
-    }
+    // Architecture is after the last dot.
+    *architecture = sr_strndup(last_dot + 1, end - last_dot - 1);
+
+    // Release is after the last dash.
+    *release = sr_strndup(last_dash + 1, last_dot - last_dash - 1);
+
+    // Version is before the last dash.
+    const char *version_start = (colon ? colon : last_but_one_dash) + 1;
+    *version = sr_strndup(version_start, last_dash - version_start);
+
+    *epoch = parsed_epoch;
 
     // Name is before version.
     *name = sr_strndup(text, last_but_one_dash - text);
@@ -797,14 +1150,13 @@ void
 sr_rpm_consistency_free(struct sr_rpm_consistency *consistency,
                         bool recursive)
 {
-    if (!consistency)
-        return;
-
-    free(consistency->path);
-    if (consistency->next && recursive)
-        sr_rpm_consistency_free(consistency->next, true);
-
-    free(consistency);
+    while (consistency)
+    {
+        struct sr_rpm_consistency *next = (recursive ? consistency->next : NULL);
+        free(consistency->path);
+        free(consistency);
+        consistency = next;
+    }
 }
 
 int
@@ -868,25 +1220,25 @@ int
 sr_rpm_consistency_cmp_recursive(struct sr_rpm_consistency *consistency1,
                                  struct sr_rpm_consistency *consistency2)
 {
-    if (consistency1)
+    /* Iterates instead of recursing, packages may list many files. */
+    while (consistency1 && consistency2)
     {
-        if (consistency2)
-        {
-            int cmp = sr_rpm_consistency_cmp(consistency1, consistency2);
-            if (cmp != 0)
-                return cmp;
-            else
-            {
-                return sr_rpm_consistency_cmp_recursive(
-                    consistency1->next,
-                    consistency2->next);
-            }
-        }
-        else
-            return 1;
+        /* The rest of a shared list is equal. */
+        if (consistency1 == consistency2)
+            return 0;
+
+        int cmp = sr_rpm_consistency_cmp(consistency1, consistency2);
+        if (cmp != 0)
+            return cmp;
+
+        consistency1 = consistency1->next;
+        consistency2 = consistency2->next;
     }
-    else
-        return consistency2 ? -1 : 0;
+
+    if (consistency1)
+        return 1;
+
+    return consistency2 ? -1 : 0;
 }
 
 struct sr_rpm_consistency *
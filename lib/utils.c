@@ -20,6 +20,8 @@
 #include "utils.h"
 #include "location.h"
 #include "strbuf.h"
+#include "hash_table.h"
+#include "internal_utils.h"
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
@@ -27,9 +29,11 @@
 #include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <pthread.h>
 
 /* The prototype is in C++ header cxxabi.h, let's just copypaste it here
  * instead of fiddling with include directories */
@@ -213,15 +217,11 @@ sr_strchr_location(const char *s, int c, int *line, int *column)
     *line = 1;
     *column = 0;
 
-    /* Scan s for the character.  When this loop is finished,
-       s will either point to the end of the string or the
-       character we were looking for.  */
-    while (*s != '\0' && *s != (char)c)
-    {
-        sr_location_eat_char_ext(line, column, *s);
-        ++s;
-    }
-    return ((*s == c) ? (char*)s : NULL);
+    /* Scan s for the character.  The result will either point to the
+       end of the string or the character we were looking for.  */
+    const char *result = strchrnul(s, c);
+    sr_location_eat_chars_ext(line, column, s, result - s);
+    return ((*result == c) ? (char*)result : NULL);
 }
 
 char *
@@ -232,24 +232,13 @@ sr_strstr_location(const char *haystack,
 {
     *line = 1;
     *column = 0;
-    size_t needlelen;
 
-    /* Check for the null needle case.  */
-    if (*needle == '\0')
-        return (char*)haystack;
-
-    needlelen = strlen(needle);
-    int chrline, chrcolumn;
-    for (;(haystack = sr_strchr_location(haystack, *needle, &chrline, &chrcolumn)) != NULL; ++haystack)
-    {
-        sr_location_add_ext(line, column, chrline, chrcolumn);
-
-        if (strncmp(haystack, needle, needlelen) == 0)
-            return (char*)haystack;
+    const char *result = strstr(haystack, needle);
+    if (!result)
+        return NULL;
 
-        sr_location_eat_char_ext(line, column, *haystack);
-    }
-    return NULL;
+    sr_location_eat_chars_ext(line, column, haystack, result - haystack);
+    return (char*)result;
 }
 
 size_t
@@ -260,15 +249,9 @@ sr_strspn_location(const char *s,
 {
     *line = 1;
     *column = 0;
-    const char *sc;
-    for (sc = s; *sc != '\0'; ++sc)
-    {
-        if (strchr(accept, *sc) == NULL)
-            return (sc - s);
-
-        sr_location_eat_char_ext(line, column, *sc);
-    }
-    return sc - s; /* terminating nulls don't match */
+    size_t count = strspn(s, accept);
+    sr_location_eat_chars_ext(line, column, s, count);
+    return count;
 }
 
 char *
@@ -299,7 +282,6 @@ sr_file_to_string(const char *filename,
 
     lseek(fd, 0, SEEK_SET); /* No reason to fail. */
 
-    static const size_t FILE_SIZE_LIMIT = 20000000; /* ~ 20 MB */
     if (size > FILE_SIZE_LIMIT)
     {
         *error_message = sr_asprintf("Input file too big (%lld). Maximum size is %zu.",
@@ -371,6 +353,158 @@ sr_string_to_file(const char *filename,
     return true;
 }
 
+/* Reads the whole file into a NUL-terminated buffer. Used for files
+ * that cannot be mapped. */
+static char *
+read_fd_to_buffer(int fd, size_t *size)
+{
+    size_t allocated = 4096, used = 0;
+    char *buffer = sr_malloc(allocated);
+    while (true)
+    {
+        if (used + 1 >= allocated)
+        {
+            allocated *= 2;
+            buffer = sr_realloc(buffer, allocated);
+        }
+
+        ssize_t count = read(fd, buffer + used, allocated - used - 1);
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count < 0)
+        {
+            free(buffer);
+            return NULL;
+        }
+
+        if (count == 0)
+            break;
+
+        used += count;
+    }
+
+    buffer[used] = '\0';
+    *size = used;
+    return buffer;
+}
+
+struct sr_mapped_file *
+sr_mapped_file_open(const char *filename,
+                    char **error_message)
+{
+    int fd = open(filename, O_RDONLY | O_LARGEFILE);
+    if (fd < 0)
+    {
+        *error_message = sr_asprintf("Unable to open '%s': %s.",
+                                     filename,
+                                     strerror(errno));
+
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        *error_message = sr_asprintf("Unable to stat '%s': %s.",
+                                     filename,
+                                     strerror(errno));
+
+        close(fd);
+        return NULL;
+    }
+
+    struct sr_mapped_file *file = sr_mallocz(sizeof(*file));
+
+    /* Empty files cannot be mapped, and neither can pipes and other
+     * special files, whose size is not known in advance. */
+    if (!S_ISREG(st.st_mode) || st.st_size == 0)
+    {
+        char *buffer = read_fd_to_buffer(fd, &file->size);
+        if (!buffer)
+        {
+            *error_message = sr_asprintf("Unable to read from '%s': %s.",
+                                         filename,
+                                         strerror(errno));
+
+            free(file);
+            close(fd);
+            return NULL;
+        }
+
+        file->contents = buffer;
+        close(fd);
+        return file;
+    }
+
+    if ((uintmax_t)st.st_size >= SIZE_MAX)
+    {
+        *error_message = sr_asprintf("Input file too big (%lld).",
+                                     (long long)st.st_size);
+
+        free(file);
+        close(fd);
+        return NULL;
+    }
+
+    /* The kernel fills the rest of the last page with zeros, which
+     * terminates the contents.  If the file ends exactly at a page
+     * boundary, an extra anonymous page is reserved behind it. */
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    file->size = st.st_size;
+    file->mapping_size = file->size;
+    if (file->size % page_size == 0)
+        file->mapping_size += page_size;
+
+    file->mapping = mmap(NULL, file->mapping_size, PROT_READ,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (file->mapping != MAP_FAILED)
+    {
+        void *contents = mmap(file->mapping, file->size, PROT_READ,
+                              MAP_PRIVATE | MAP_FIXED, fd, 0);
+
+        if (contents == MAP_FAILED)
+        {
+            int mmap_errno = errno;
+            munmap(file->mapping, file->mapping_size);
+            errno = mmap_errno;
+            file->mapping = MAP_FAILED;
+        }
+    }
+
+    if (file->mapping == MAP_FAILED)
+    {
+        *error_message = sr_asprintf("Unable to map '%s': %s.",
+                                     filename,
+                                     strerror(errno));
+
+        free(file);
+        close(fd);
+        return NULL;
+    }
+
+    /* The mapping stays valid after the descriptor is closed. */
+    close(fd);
+
+    file->contents = file->mapping;
+    return file;
+}
+
+void
+sr_mapped_file_close(struct sr_mapped_file *file)
+{
+    if (!file)
+        return;
+
+    if (file->mapping)
+        munmap(file->mapping, file->mapping_size);
+    else
+        free((char *)file->contents);
+
+    free(file);
+}
+
 bool
 sr_skip_char(const char **input, char c)
 {
@@ -660,7 +794,9 @@ sr_skip_non_whitespace(const char *s)
 bool
 sr_skip_to_next_line_location(const char **s, int *line, int *column)
 {
-    *column += sr_skip_char_cspan(s, "\n");
+    const char *newline = strchrnul(*s, '\n');
+    *column += newline - *s;
+    *s = newline;
 
     if (**s == '\n')
     {
@@ -673,6 +809,33 @@ sr_skip_to_next_line_location(const char **s, int *line, int *column)
     return false;
 }
 
+int
+sr_parse_uint64_n(const char **input, const char *end, uint64_t *result)
+{
+    /* Digits are accumulated directly instead of going through strtoull,
+     * which would need a NUL-terminated copy of the number.  The same
+     * values as in sr_parse_uint64 are rejected.
+     */
+    const char *local_input = *input;
+    uint64_t r = 0;
+    while (local_input < end && *local_input >= '0' && *local_input <= '9')
+    {
+        unsigned digit = *local_input - '0';
+        if (r > (UINT64_MAX - digit) / 10)
+            return 0;
+        r = r * 10 + digit;
+        ++local_input;
+    }
+
+    if (local_input == *input || r == UINT64_MAX)
+        return 0;
+
+    int count = local_input - *input;
+    *result = r;
+    *input = local_input;
+    return count;
+}
+
 char *
 sr_bin2hex(char *dst, const char *str, int count)
 {
@@ -832,13 +995,39 @@ sr_parse_os_release(const char *input, void (*callback)(char*, char*, void*),
     }
 }
 
-char *
-sr_demangle_symbol(const char *sym)
-{
-    /* Prevent __cxa_demangle from demangling e.g. "f" to "float". */
-    if (0 != strncmp("_Z", sym, 2))
-        return NULL;
+/* Default number of symbols kept by the demangling cache. */
+#define DEMANGLE_CACHE_CAPACITY 4096
 
+struct demangle_entry
+{
+    char *mangled;
+    /* NULL if the symbol cannot be demangled. */
+    char *demangled;
+    struct demangle_entry *prev;
+    struct demangle_entry *next;
+};
+
+/* LRU cache of demangled symbols.  The entries are kept in a doubly
+ * linked list ordered from the most recently used one, the hash table
+ * maps the mangled names to the entries.  Everything is protected by the
+ * lock, the cache is shared by all threads. */
+static struct
+{
+    pthread_mutex_t lock;
+    struct hash_table *table;
+    struct demangle_entry *head;
+    struct demangle_entry *tail;
+    size_t capacity;
+    unsigned long hits;
+    unsigned long misses;
+} demangle_cache = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .capacity = DEMANGLE_CACHE_CAPACITY,
+};
+
+static char *
+demangle_uncached(const char *sym)
+{
     int status;
     char *demangled = __cxa_demangle(sym, NULL, 0, &status);
 
@@ -849,3 +1038,211 @@ sr_demangle_symbol(const char *sym)
 
     return demangled;
 }
+
+static void
+demangle_cache_unlink(struct demangle_entry *entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        demangle_cache.head = entry->next;
+
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        demangle_cache.tail = entry->prev;
+}
+
+static void
+demangle_cache_push_front(struct demangle_entry *entry)
+{
+    entry->prev = NULL;
+    entry->next = demangle_cache.head;
+    if (demangle_cache.head)
+        demangle_cache.head->prev = entry;
+    else
+        demangle_cache.tail = entry;
+
+    demangle_cache.head = entry;
+}
+
+/* Drops the least recently used entries until at most capacity remain. */
+static void
+demangle_cache_shrink(size_t capacity)
+{
+    while (demangle_cache.table
+           && hash_table_size(demangle_cache.table) > capacity)
+    {
+        struct demangle_entry *entry = demangle_cache.tail;
+        hash_table_remove(demangle_cache.table, entry->mangled);
+        demangle_cache_unlink(entry);
+        free(entry->mangled);
+        free(entry->demangled);
+        free(entry);
+    }
+}
+
+/* Stores a copy of the cached demangled name of sym to *demangled.
+ * Returns false on a miss.  Must be called with the lock held. */
+static bool
+demangle_cache_lookup(const char *sym, char **demangled)
+{
+    void *value;
+    if (!demangle_cache.table
+        || !hash_table_lookup(demangle_cache.table, sym, &value))
+    {
+        ++demangle_cache.misses;
+        return false;
+    }
+
+    struct demangle_entry *entry = value;
+    ++demangle_cache.hits;
+    demangle_cache_unlink(entry);
+    demangle_cache_push_front(entry);
+    *demangled = (entry->demangled ? sr_strdup(entry->demangled) : NULL);
+    return true;
+}
+
+/* Stores a copy of the demangled name of sym, unless another thread has
+ * stored it in the meantime.  Must be called with the lock held. */
+static void
+demangle_cache_insert(const char *sym, const char *demangled)
+{
+    if (demangle_cache.capacity == 0)
+        return;
+
+    if (!demangle_cache.table)
+    {
+        demangle_cache.table = hash_table_new(hash_string,
+                                              string_equal,
+                                              NULL, NULL);
+    }
+    else if (hash_table_lookup(demangle_cache.table, sym, NULL))
+        return;
+
+    demangle_cache_shrink(demangle_cache.capacity - 1);
+
+    struct demangle_entry *entry = sr_malloc(sizeof(*entry));
+    entry->mangled = sr_strdup(sym);
+    entry->demangled = (demangled ? sr_strdup(demangled) : NULL);
+    hash_table_insert(demangle_cache.table, entry->mangled, entry);
+    demangle_cache_push_front(entry);
+}
+
+char *
+sr_demangle_symbol(const char *sym)
+{
+    char *result;
+    sr_demangle_symbols(&sym, 1, &result);
+    return result;
+}
+
+void
+sr_demangle_symbols(const char *const *symbols,
+                    size_t count,
+                    char **results)
+{
+    /* The symbols missing from the cache are demangled without the lock,
+     * so that other threads are not held up by __cxa_demangle.  missed[i]
+     * is the index of the first occurrence of a missing symbols[i], the
+     * repeated occurrences count as hits. */
+    if (count == 0)
+        return;
+
+    size_t *missed = sr_malloc_array(count, sizeof(*missed));
+    struct hash_table *batch = NULL;
+
+    pthread_mutex_lock(&demangle_cache.lock);
+    bool cached = (demangle_cache.capacity > 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        results[i] = NULL;
+        missed[i] = SIZE_MAX;
+
+        /* Prevent __cxa_demangle from demangling e.g. "f" to "float". */
+        if (!symbols[i] || 0 != strncmp("_Z", symbols[i], 2))
+            continue;
+
+        if (!cached)
+        {
+            missed[i] = i;
+            continue;
+        }
+
+        void *first;
+        if (batch && hash_table_lookup(batch, symbols[i], &first))
+        {
+            ++demangle_cache.hits;
+            missed[i] = (size_t)(uintptr_t)first;
+        }
+        else if (!demangle_cache_lookup(symbols[i], &results[i]))
+        {
+            if (!batch)
+                batch = hash_table_new(hash_string, string_equal, NULL, NULL);
+
+            hash_table_insert(batch, (void *)symbols[i], (void *)(uintptr_t)i);
+            missed[i] = i;
+        }
+    }
+
+    pthread_mutex_unlock(&demangle_cache.lock);
+
+    if (!cached || batch)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (missed[i] == i)
+                results[i] = demangle_uncached(symbols[i]);
+            else if (missed[i] != SIZE_MAX && results[missed[i]])
+                results[i] = sr_strdup(results[missed[i]]);
+        }
+    }
+
+    if (batch)
+    {
+        pthread_mutex_lock(&demangle_cache.lock);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (missed[i] == i)
+                demangle_cache_insert(symbols[i], results[i]);
+        }
+
+        pthread_mutex_unlock(&demangle_cache.lock);
+        hash_table_free(batch);
+    }
+
+    free(missed);
+}
+
+void
+sr_demangle_cache_set_capacity(size_t capacity)
+{
+    pthread_mutex_lock(&demangle_cache.lock);
+    demangle_cache.capacity = capacity;
+    demangle_cache_shrink(capacity);
+    pthread_mutex_unlock(&demangle_cache.lock);
+}
+
+void
+sr_demangle_cache_clear(void)
+{
+    pthread_mutex_lock(&demangle_cache.lock);
+    demangle_cache_shrink(0);
+    hash_table_free(demangle_cache.table);
+    demangle_cache.table = NULL;
+    demangle_cache.hits = 0;
+    demangle_cache.misses = 0;
+    pthread_mutex_unlock(&demangle_cache.lock);
+}
+
+void
+sr_demangle_cache_get_stats(struct sr_demangle_cache_stats *stats)
+{
+    pthread_mutex_lock(&demangle_cache.lock);
+    stats->hits = demangle_cache.hits;
+    stats->misses = demangle_cache.misses;
+    stats->size = (demangle_cache.table
+                   ? hash_table_size(demangle_cache.table) : 0);
+    stats->capacity = demangle_cache.capacity;
+    pthread_mutex_unlock(&demangle_cache.lock);
+}
@@ -71,11 +71,60 @@ sr_py_demangle_symbol(PyObject *self, PyObject *args)
     return result;
 }
 
+static PyObject *
+sr_py_demangle_symbols(PyObject *self, PyObject *args)
+{
+    PyObject *list;
+
+    if (!PyArg_ParseTuple(args, "O!", &PyList_Type, &list))
+        return NULL;
+
+    Py_ssize_t count = PyList_Size(list);
+    const char **mangled = sr_malloc_array(count + 1, sizeof(*mangled));
+    char **demangled = sr_malloc_array(count + 1, sizeof(*demangled));
+
+    for (Py_ssize_t i = 0; i < count; ++i)
+    {
+        mangled[i] = PyString_AsString(PyList_GetItem(list, i));
+        if (!mangled[i])
+        {
+            free(mangled);
+            free(demangled);
+            return NULL;
+        }
+    }
+
+    sr_demangle_symbols(mangled, count, demangled);
+
+    PyObject *result = PyList_New(count);
+    for (Py_ssize_t i = 0; i < count; ++i)
+    {
+        if (result)
+        {
+            PyObject *item = PyString_FromString(demangled[i] ? demangled[i]
+                                                              : mangled[i]);
+            if (item)
+                PyList_SET_ITEM(result, i, item);
+            else
+            {
+                Py_DECREF(result);
+                result = NULL;
+            }
+        }
+
+        free(demangled[i]);
+    }
+
+    free(mangled);
+    free(demangled);
+    return result;
+}
 
 static PyMethodDef
 module_methods[]=
 {
     { "demangle_symbol", sr_py_demangle_symbol, METH_VARARGS, "Demangle C++ symbol." },
+    { "demangle_symbols", sr_py_demangle_symbols, METH_VARARGS, "Demangle a list of C++ symbols." },
     { NULL },
 };
 
@@ -26,20 +26,30 @@
 #include "location.h"
 #include "strbuf.h"
 #include "cluster.h"
+#include "distance.h"
 #include "normalize.h"
 #include "report.h"
 #include "abrt.h"
 #include "thread.h"
 #include "stacktrace.h"
+#include "json.h"
 #include "config.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <argp.h>
 #include <sysexits.h>
 #include <assert.h>
 #include <libgen.h>
 #include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
 
 static char *g_program_name;
 
@@ -53,6 +63,9 @@ help()
     puts("   abrt-report-dir              Create report from an ABRT directory and");
     puts("                                send it to a server");
     puts("   abrt-create-core-stacktrace  Create core stacktrace from an ABRT directory");
+    puts("   batch                        Create core stacktraces of many coredumps");
+    puts("   serve                        Answer hashing and clustering requests");
+    puts("                                sent over a Unix socket");
     puts("   debug                        Commands for debugging and development support");
 }
 
@@ -71,6 +84,8 @@ usage()
     printf("Usage: %s abrt-print-report-from-dir DIR [OPTION...]\n", g_program_name);
     printf("Usage: %s abrt-report-dir DIR URL [OPTION...]\n", g_program_name);
     printf("Usage: %s abrt-create-core-stacktrace DIR [OPTION...]\n", g_program_name);
+    printf("Usage: %s batch [-j WORKERS] [MANIFEST]\n", g_program_name);
+    printf("Usage: %s serve [-j WORKERS] SOCKET\n", g_program_name);
     printf("Usage: %s debug COMMAND [OPTION...]\n", g_program_name);
 }
 
@@ -141,6 +156,680 @@ abrt_create_core_stacktrace(int argc, char **argv)
     }
 }
 
+struct batch
+{
+    FILE *input;
+    pthread_mutex_t input_lock;
+    /* Serializes the output lines. */
+    pthread_mutex_t output_lock;
+    unsigned long failed;
+};
+
+/* Turns the pretty-printed JSON into a single line in place.  Strings in
+ * the JSON have their newlines escaped, so every newline and the
+ * indentation following it are formatting. */
+static void
+json_to_single_line(char *json)
+{
+    char *out = json;
+    for (const char *in = json; *in; ++in)
+    {
+        if (*in == '\n')
+        {
+            in += strspn(in + 1, " ");
+            continue;
+        }
+
+        *out++ = *in;
+    }
+
+    *out = '\0';
+}
+
+/* Unwinds one manifest line.  The line is either an ABRT problem directory
+ * or a coredump and an executable separated by a tab. */
+static struct sr_core_stacktrace *
+batch_unwind(const char *line, char **error_message)
+{
+    const char *tab = strchr(line, '\t');
+    if (tab)
+    {
+        char *coredump = sr_strndup(line, tab - line);
+        struct sr_core_stacktrace *stacktrace =
+            sr_parse_coredump(coredump, tab + 1, error_message);
+
+        free(coredump);
+        return stacktrace;
+    }
+
+    char *executable_path = sr_build_path(line, "executable", NULL);
+    char *executable = sr_file_to_string(executable_path, error_message);
+    free(executable_path);
+    if (!executable)
+        return NULL;
+
+    /* The file usually ends with a newline. */
+    executable[strcspn(executable, "\n")] = '\0';
+
+    char *coredump = sr_build_path(line, "coredump", NULL);
+    struct sr_core_stacktrace *stacktrace =
+        sr_parse_coredump(coredump, executable, error_message);
+
+    free(coredump);
+    free(executable);
+    return stacktrace;
+}
+
+static void *
+batch_worker(void *arg)
+{
+    struct batch *batch = arg;
+    char *line = NULL;
+    size_t allocated = 0;
+
+    while (true)
+    {
+        pthread_mutex_lock(&batch->input_lock);
+        ssize_t length = getline(&line, &allocated, batch->input);
+        pthread_mutex_unlock(&batch->input_lock);
+
+        if (length < 0)
+            break;
+
+        if (length > 0 && line[length - 1] == '\n')
+            line[--length] = '\0';
+
+        if (length == 0)
+            continue;
+
+        char *error_message = NULL;
+        struct sr_core_stacktrace *stacktrace = batch_unwind(line,
+                                                             &error_message);
+
+        struct sr_strbuf *strbuf = sr_strbuf_new();
+        sr_strbuf_append_str(strbuf, "{\"input\": ");
+        sr_json_append_escaped(strbuf, line);
+        if (stacktrace)
+        {
+            char *json = sr_core_stacktrace_to_json(stacktrace);
+            json_to_single_line(json);
+            sr_strbuf_append_str(strbuf, ", \"core_backtrace\": ");
+            sr_strbuf_append_str(strbuf, json);
+            sr_strbuf_append_str(strbuf, "}\n");
+            free(json);
+            sr_core_stacktrace_free(stacktrace);
+        }
+        else
+        {
+            sr_strbuf_append_str(strbuf, ", \"error\": ");
+            sr_json_append_escaped(strbuf, error_message ? error_message
+                                                         : "Unwinding failed");
+            sr_strbuf_append_str(strbuf, "}\n");
+            free(error_message);
+        }
+
+        pthread_mutex_lock(&batch->output_lock);
+        if (!stacktrace)
+            ++batch->failed;
+
+        fputs(strbuf->buf, stdout);
+        fflush(stdout);
+        pthread_mutex_unlock(&batch->output_lock);
+        sr_strbuf_free(strbuf);
+    }
+
+    free(line);
+    return NULL;
+}
+
+static void
+batch(int argc, char **argv)
+{
+    unsigned long workers = 1;
+    if (argc > 1 && 0 == strcmp(argv[0], "-j"))
+    {
+        char *end;
+        workers = strtoul(argv[1], &end, 10);
+        if (*end != '\0' || workers == 0)
+        {
+            fprintf(stderr, "Wrong number of workers\n");
+            exit(1);
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+    struct batch state = {
+        .input = stdin,
+        .input_lock = PTHREAD_MUTEX_INITIALIZER,
+        .output_lock = PTHREAD_MUTEX_INITIALIZER,
+    };
+
+    if (argc > 0 && 0 != strcmp(argv[0], "-"))
+    {
+        state.input = fopen(argv[0], "r");
+        if (!state.input)
+        {
+            fprintf(stderr, "Unable to open '%s': %s\n", argv[0],
+                    strerror(errno));
+            exit(1);
+        }
+    }
+
+    /* All the coredumps are unwound in this process, so the build id and
+     * demangling caches are shared by the workers and by the consecutive
+     * coredumps of the same binaries. */
+    pthread_t *threads = sr_malloc_array(workers, sizeof(*threads));
+    unsigned long started;
+    for (started = 0; started < workers; ++started)
+    {
+        if (0 != pthread_create(&threads[started], NULL, batch_worker, &state))
+            break;
+    }
+
+    if (started == 0)
+        batch_worker(&state);
+
+    for (unsigned long i = 0; i < started; ++i)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+    if (state.input != stdin)
+        fclose(state.input);
+
+    if (state.failed > 0)
+        exit(1);
+}
+
+/* Requests with a larger payload are refused, so that a broken client
+ * cannot make the server allocate an arbitrary amount of memory. */
+#define SERVE_MAX_PAYLOAD (256 * 1024 * 1024)
+/* The same for the request header, including the newline. */
+#define SERVE_MAX_HEADER 4096
+/* Seconds a client may stay idle before its connection is closed, so that
+ * it does not keep a worker from accepting other connections. */
+#define SERVE_TIMEOUT 30
+
+struct serve
+{
+    int socket;
+    /* Serializes the messages printed to standard error. */
+    pthread_mutex_t log_lock;
+};
+
+static char *
+serve_duphash(char **args, int count, const char *payload, size_t length,
+              char **error_message)
+{
+    if (count < 1 || count > 2)
+    {
+        *error_message = sr_strdup("Usage: duphash TYPE [COMPONENT] LENGTH");
+        return NULL;
+    }
+
+    enum sr_report_type type = sr_report_type_from_string(args[0]);
+    if (type == SR_REPORT_INVALID)
+    {
+        *error_message = sr_asprintf("Invalid report type %s", args[0]);
+        return NULL;
+    }
+
+    struct sr_stacktrace *stacktrace = sr_stacktrace_parse_n(type, payload,
+                                                             length,
+                                                             error_message);
+    if (!stacktrace)
+        return NULL;
+
+    char *duphash = NULL;
+    struct sr_thread *thread = sr_stacktrace_find_crash_thread(stacktrace);
+    if (!thread)
+        *error_message = sr_strdup("Cannot find crash thread");
+    else
+    {
+        duphash = sr_thread_get_duphash(thread, 3,
+                                        count > 1 ? args[1] : NULL,
+                                        SR_DUPHASH_NORMAL);
+        if (!duphash)
+            *error_message = sr_strdup("Computing duphash failed");
+    }
+
+    sr_stacktrace_free(stacktrace);
+    return duphash;
+}
+
+static char *
+serve_bthash(char **args, int count, const char *payload, size_t length,
+             char **error_message)
+{
+    if (count != 0)
+    {
+        *error_message = sr_strdup("Usage: bthash LENGTH");
+        return NULL;
+    }
+
+    /* The payload is NUL-terminated by serve_connection(). */
+    struct sr_report *report = sr_report_from_json_text(payload,
+                                                        error_message);
+    if (!report)
+        return NULL;
+
+    char *bthash = NULL;
+    if (!report->stacktrace)
+        *error_message = sr_strdup("The report contains no stacktrace");
+    else
+    {
+        bthash = sr_stacktrace_get_bthash(report->stacktrace,
+                                          SR_BTHASH_NORMAL);
+        if (!bthash)
+            *error_message = sr_strdup("Computing bthash failed");
+    }
+
+    sr_report_free(report);
+    return bthash;
+}
+
+/* The payload is a line of the batch manifest, the reply is the core
+ * stacktrace in JSON on a single line. */
+static char *
+serve_unwind(char **args, int count, const char *payload, size_t length,
+             char **error_message)
+{
+    if (count != 0)
+    {
+        *error_message = sr_strdup("Usage: unwind LENGTH");
+        return NULL;
+    }
+
+    char *line = sr_strndup(payload, strcspn(payload, "\n"));
+    struct sr_core_stacktrace *stacktrace = batch_unwind(line, error_message);
+    free(line);
+    if (!stacktrace)
+        return NULL;
+
+    char *json = sr_core_stacktrace_to_json(stacktrace);
+    json_to_single_line(json);
+    sr_core_stacktrace_free(stacktrace);
+    return json;
+}
+
+/* The payload consists of stacktraces separated by NUL bytes.  The crash
+ * threads of the stacktraces are clustered, and every cluster is
+ * returned on a line as the indices of its stacktraces. */
+static char *
+serve_cluster(char **args, int count, const char *payload, size_t length,
+              char **error_message)
+{
+    if (count != 2)
+    {
+        *error_message = sr_strdup("Usage: cluster TYPE LEVEL LENGTH");
+        return NULL;
+    }
+
+    enum sr_report_type type = sr_report_type_from_string(args[0]);
+    if (type == SR_REPORT_INVALID)
+    {
+        *error_message = sr_asprintf("Invalid report type %s", args[0]);
+        return NULL;
+    }
+
+    char *end;
+    float level = strtof(args[1], &end);
+    if (*end != '\0' || level < 0)
+    {
+        *error_message = sr_asprintf("Invalid level %s", args[1]);
+        return NULL;
+    }
+
+    size_t allocated = 16, stacktrace_count = 0;
+    struct sr_stacktrace **stacktraces =
+        sr_malloc_array(allocated, sizeof(*stacktraces));
+    struct sr_thread **threads = sr_malloc_array(allocated, sizeof(*threads));
+
+    char *result = NULL;
+    const char *payload_end = payload + length;
+    for (const char *p = payload; p < payload_end; )
+    {
+        const char *separator = memchr(p, '\0', payload_end - p);
+        if (!separator)
+            separator = payload_end;
+
+        struct sr_stacktrace *stacktrace =
+            sr_stacktrace_parse_n(type, p, separator - p, error_message);
+        if (!stacktrace)
+        {
+            char *message = *error_message;
+            *error_message = sr_asprintf("Stacktrace %zu: %s",
+                                         stacktrace_count, message);
+            free(message);
+            goto fail;
+        }
+
+        struct sr_thread *thread = sr_stacktrace_find_crash_thread(stacktrace);
+        if (!thread)
+        {
+            sr_stacktrace_free(stacktrace);
+            *error_message = sr_asprintf("Stacktrace %zu: Cannot find crash thread",
+                                         stacktrace_count);
+            goto fail;
+        }
+
+        if (stacktrace_count == allocated)
+        {
+            allocated *= 2;
+            stacktraces = sr_realloc_array(stacktraces, allocated,
+                                           sizeof(*stacktraces));
+            threads = sr_realloc_array(threads, allocated, sizeof(*threads));
+        }
+
+        stacktraces[stacktrace_count] = stacktrace;
+        threads[stacktrace_count++] = thread;
+        p = separator + 1;
+    }
+
+    if (stacktrace_count < 2)
+    {
+        *error_message = sr_strdup("At least two stacktraces are required");
+        goto fail;
+    }
+
+    struct sr_distances *distances =
+        sr_threads_compare(threads, stacktrace_count, stacktrace_count,
+                           SR_DISTANCE_LEVENSHTEIN);
+    struct sr_dendrogram *dendrogram = sr_distances_cluster_objects(distances);
+    struct sr_cluster *clusters = sr_dendrogram_cut(dendrogram, level, 1);
+
+    struct sr_strbuf *strbuf = sr_strbuf_new();
+    for (struct sr_cluster *cluster = clusters; cluster; cluster = cluster->next)
+    {
+        for (int i = 0; i < cluster->size; ++i)
+        {
+            sr_strbuf_append_strf(strbuf, i == 0 ? "%d" : " %d",
+                                  cluster->objects[i]);
+        }
+
+        sr_strbuf_append_char(strbuf, '\n');
+    }
+
+    while (clusters)
+    {
+        struct sr_cluster *next = clusters->next;
+        sr_cluster_free(clusters);
+        clusters = next;
+    }
+
+    sr_dendrogram_free(dendrogram);
+    sr_distances_free(distances);
+    result = sr_strbuf_free_nobuf(strbuf);
+
+fail:
+    for (size_t i = 0; i < stacktrace_count; ++i)
+        sr_stacktrace_free(stacktraces[i]);
+
+    free(stacktraces);
+    free(threads);
+    return result;
+}
+
+static bool
+serve_write(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(fd, data, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        data += written;
+        length -= written;
+    }
+
+    return true;
+}
+
+static bool
+serve_reply(int fd, const char *status, const char *payload)
+{
+    size_t length = strlen(payload);
+    char *header = sr_asprintf("%s %zu\n", status, length);
+    bool success = serve_write(fd, header, strlen(header)) &&
+                   serve_write(fd, payload, length);
+
+    free(header);
+    return success;
+}
+
+/* Answers the requests sent over the connection until the client closes
+ * it.  Every request is a line with the command, its arguments and the
+ * length of the payload separated by spaces, followed by the payload.
+ * The reply is a line with OK or ERROR and the length of the payload,
+ * followed by the result or the error message. */
+static void
+serve_connection(int fd)
+{
+    FILE *input = fdopen(fd, "r");
+    if (!input)
+    {
+        close(fd);
+        return;
+    }
+
+    char line[SERVE_MAX_HEADER];
+    char *payload = NULL;
+    size_t payload_allocated = 0;
+    while (fgets(line, sizeof(line), input))
+    {
+        size_t line_length = strlen(line);
+        if (line_length > 0 && line[line_length - 1] == '\n')
+            line[--line_length] = '\0';
+        else if (ferror(input))
+            break;
+        else if (!feof(input))
+        {
+            /* The rest of the line would be taken for the payload. */
+            serve_reply(fd, "ERROR", "Malformed request header");
+            break;
+        }
+
+        char *args[8], *saveptr;
+        int count = 0;
+        for (char *token = strtok_r(line, " ", &saveptr);
+             token;
+             token = strtok_r(NULL, " ", &saveptr))
+        {
+            /* Too many arguments make the header malformed. */
+            if (count == 8)
+            {
+                count = 0;
+                break;
+            }
+
+            args[count++] = token;
+        }
+
+        char *end = NULL;
+        unsigned long long length = count >= 2 ? strtoull(args[count - 1], &end, 10)
+                                               : 0;
+        if (count < 2 || *end != '\0' || length > SERVE_MAX_PAYLOAD)
+        {
+            /* The payload cannot be skipped without its length. */
+            serve_reply(fd, "ERROR", "Malformed request header");
+            break;
+        }
+
+        if (length >= payload_allocated)
+        {
+            payload_allocated = length + 1;
+            payload = sr_realloc(payload, payload_allocated);
+        }
+
+        if (length != fread(payload, 1, length, input))
+            break;
+
+        payload[length] = '\0';
+
+        char *(*handler)(char **, int, const char *, size_t, char **) = NULL;
+        if (0 == strcmp(args[0], "duphash"))
+            handler = serve_duphash;
+        else if (0 == strcmp(args[0], "bthash"))
+            handler = serve_bthash;
+        else if (0 == strcmp(args[0], "cluster"))
+            handler = serve_cluster;
+        else if (0 == strcmp(args[0], "unwind"))
+            handler = serve_unwind;
+
+        char *error_message = NULL, *result = NULL;
+        if (handler)
+            result = handler(args + 1, count - 2, payload, length, &error_message);
+        else
+            error_message = sr_asprintf("Unknown command %s", args[0]);
+
+        bool success;
+        if (result)
+            success = serve_reply(fd, "OK", result);
+        else
+            success = serve_reply(fd, "ERROR", error_message ? error_message
+                                                             : "Request failed");
+
+        free(result);
+        free(error_message);
+        if (!success)
+            break;
+    }
+
+    free(payload);
+    fclose(input);
+}
+
+static void *
+serve_worker(void *arg)
+{
+    struct serve *serve = arg;
+    while (true)
+    {
+        int fd = accept(serve->socket, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            pthread_mutex_lock(&serve->log_lock);
+            fprintf(stderr, "accept: %s\n", strerror(errno));
+            pthread_mutex_unlock(&serve->log_lock);
+            break;
+        }
+
+        struct timeval timeout = { .tv_sec = SERVE_TIMEOUT };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        serve_connection(fd);
+    }
+
+    return NULL;
+}
+
+static void
+serve(int argc, char **argv)
+{
+    unsigned long workers = 1;
+    if (argc > 1 && 0 == strcmp(argv[0], "-j"))
+    {
+        char *end;
+        workers = strtoul(argv[1], &end, 10);
+        if (*end != '\0' || workers == 0)
+        {
+            fprintf(stderr, "Wrong number of workers\n");
+            exit(1);
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc != 1)
+    {
+        fprintf(stderr, "Missing socket path.\n");
+        short_usage_and_exit();
+    }
+
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(argv[0]) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Socket path '%s' is too long\n", argv[0]);
+        exit(1);
+    }
+
+    strcpy(address.sun_path, argv[0]);
+
+    struct serve state = {
+        .socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0),
+        .log_lock = PTHREAD_MUTEX_INITIALIZER,
+    };
+
+    if (state.socket < 0)
+    {
+        fprintf(stderr, "socket: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    /* A socket left behind by a previous server would make bind fail, but
+     * anything else at the path is not ours to remove. */
+    struct stat st;
+    if (0 == lstat(argv[0], &st))
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            fprintf(stderr, "'%s' exists and is not a socket\n", argv[0]);
+            exit(1);
+        }
+
+        unlink(argv[0]);
+    }
+    else if (errno != ENOENT)
+    {
+        fprintf(stderr, "Unable to stat '%s': %s\n", argv[0],
+                strerror(errno));
+        exit(1);
+    }
+
+    if (0 != bind(state.socket, (struct sockaddr *)&address, sizeof(address)) ||
+        0 != listen(state.socket, SOMAXCONN))
+    {
+        fprintf(stderr, "Unable to listen on '%s': %s\n", argv[0],
+                strerror(errno));
+        exit(1);
+    }
+
+    /* A client closing its connection early must not kill the server. */
+    signal(SIGPIPE, SIG_IGN);
+
+    /* The server lives as long as it is not killed, so the normalization
+     * rules, the demangling and build id caches and the other lazily built
+     * tables are shared by all the requests after the first one. */
+    pthread_t *threads = sr_malloc_array(workers, sizeof(*threads));
+    unsigned long started;
+    for (started = 0; started < workers; ++started)
+    {
+        if (0 != pthread_create(&threads[started], NULL, serve_worker, &state))
+            break;
+    }
+
+    if (started == 0)
+        serve_worker(&state);
+
+    for (unsigned long i = 0; i < started; ++i)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+    close(state.socket);
+    exit(1);
+}
+
 static void
 debug_normalize(int argc, char **argv)
 {
@@ -152,8 +841,8 @@ debug_normalize(int argc, char **argv)
     }
 
     char *error_message;
-    char *text = sr_file_to_string(argv[0], &error_message);
-    if (!text)
+    struct sr_mapped_file *file = sr_mapped_file_open(argv[0], &error_message);
+    if (!file)
     {
         fprintf(stderr, "%s\n", error_message);
         exit(1);
@@ -161,7 +850,7 @@ debug_normalize(int argc, char **argv)
 
     struct sr_gdb_thread *thread = sr_gdb_thread_new();
 
-    char *cur = text;
+    const char *cur = file->contents;
 
     /* Parse the text. */
     while (*cur)
@@ -173,7 +862,7 @@ debug_normalize(int argc, char **argv)
         /* if ( character is found, we do not stop on white space, but on ) */
         /* parentheses may be nested, we need to consider the depth */
         sr_skip_whitespace(cur);
-        char *end;
+        const char *end;
         for (end = cur; *end && *end != ' '; ++end)
         {
         }
@@ -211,7 +900,7 @@ debug_normalize(int argc, char **argv)
     sr_gdb_thread_append_to_str(thread, strbuf, false);
     puts(strbuf->buf);
 
-    free(text);
+    sr_mapped_file_close(file);
     sr_strbuf_free(strbuf);
 }
 
@@ -234,15 +923,16 @@ debug_duphash(int argc, char **argv)
     }
 
     char *error_message;
-    char *text = sr_file_to_string(argv[1], &error_message);
-    if (!text)
+    struct sr_mapped_file *file = sr_mapped_file_open(argv[1], &error_message);
+    if (!file)
     {
         fprintf(stderr, "%s\n", error_message);
         exit(1);
     }
 
-    struct sr_stacktrace *stacktrace = sr_stacktrace_parse(type, text,
+    struct sr_stacktrace *stacktrace = sr_stacktrace_parse(type, file->contents,
                                                            &error_message);
+    sr_mapped_file_close(file);
     if (!stacktrace)
     {
         fprintf(stderr, "%s\n", error_message);
@@ -400,6 +1090,10 @@ main(int argc, char **argv)
         abrt_report_dir(argc - 2, argv + 2);
     else if (0 == strcmp(argv[1], "abrt-create-core-stacktrace"))
         abrt_create_core_stacktrace(argc - 2, argv + 2);
+    else if (0 == strcmp(argv[1], "batch"))
+        batch(argc - 2, argv + 2);
+    else if (0 == strcmp(argv[1], "serve"))
+        serve(argc - 2, argv + 2);
     else if (0 == strcmp(argv[1], "debug"))
         debug(argc - 2, argv + 2);
     else
@@ -0,0 +1,608 @@
+/*
+    benchmark.c
+
+    Copyright (C) 2013  Red Hat, Inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/* Measures the speed of the parsers, the hashing, the normalization, the
+ * distances and the clustering on the test fixtures and on inputs scaled up from them.
+ * Every benchmark prints a JSON object on a single line:
+ *
+ *   {"name": "parse/gdb", "iterations": 1200, "ns_per_op": 83000.1,
+ *    "ops_per_sec": 12048.2, "bytes_per_sec": 2.1e8, "peak_rss_kb": 10240}
+ *
+ * bytes_per_sec is present only for the benchmarks consuming text.  The
+ * peak RSS is the maximum of the whole process so far, so it only grows
+ * from one benchmark to the next.
+ *
+ * With -n THREADS, a synthetic corpus of that many threads (see corpus.h)
+ * is clustered once as well, and the result is compared with the known
+ * clusters of the corpus by the pairs of threads placed together.
+ */
+#include "cluster.h"
+#include "corpus.h"
+#include "distance.h"
+#include "frame.h"
+#include "gdb/frame.h"
+#include "gdb/thread.h"
+#include "normalize.h"
+#include "report.h"
+#include "stacktrace.h"
+#include "strbuf.h"
+#include "thread.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+struct benchmark
+{
+    char *name;
+    /* Runs one operation. */
+    void (*run)(struct benchmark *benchmark);
+    enum sr_report_type type;
+    char *text;
+    size_t length;
+    struct sr_stacktrace *stacktrace;
+    struct sr_thread **threads;
+    int thread_count;
+    enum sr_distance_type distance;
+    struct sr_distances *distances;
+    struct sr_gdb_thread *gdb_thread;
+};
+
+static const char *fixtures[][2] =
+{
+    { "gdb", "gdb_stacktraces/rhbz-803600" },
+    { "kerneloops", "kerneloopses/gitlog-01" },
+    { "python", "python_stacktraces/python-01" },
+    { "java", "java_stacktraces/java-01" },
+    { "ruby", "ruby_stacktraces/ruby-01" },
+    { "core", "json_files/core-01" },
+};
+
+static const char *distance_names[SR_DISTANCE_NUM] =
+{
+    [SR_DISTANCE_JARO_WINKLER] = "jaro_winkler",
+    [SR_DISTANCE_JACCARD] = "jaccard",
+    [SR_DISTANCE_LEVENSHTEIN] = "levenshtein",
+    [SR_DISTANCE_DAMERAU_LEVENSHTEIN] = "damerau_levenshtein",
+};
+
+/* The scaled-up inputs. */
+#define SCALED_THREADS 100
+#define SCALED_FRAMES 60
+#define NORMALIZED_FRAMES 1000
+
+static double min_seconds = 0.5;
+static const char *filter;
+
+static void
+fail(const char *message)
+{
+    fprintf(stderr, "%s\n", message);
+    exit(1);
+}
+
+static struct sr_stacktrace *
+parse(enum sr_report_type type, const char *text)
+{
+    char *error_message = NULL;
+    struct sr_stacktrace *stacktrace = sr_stacktrace_parse(type, text,
+                                                           &error_message);
+    if (!stacktrace)
+        fail(error_message);
+
+    return stacktrace;
+}
+
+static void
+run_parse(struct benchmark *benchmark)
+{
+    sr_stacktrace_free(parse(benchmark->type, benchmark->text));
+}
+
+static void
+run_duphash(struct benchmark *benchmark)
+{
+    struct sr_thread *thread =
+        sr_stacktrace_find_crash_thread(benchmark->stacktrace);
+
+    free(sr_thread_get_duphash(thread, 3, NULL, SR_DUPHASH_NORMAL));
+}
+
+static void
+run_bthash(struct benchmark *benchmark)
+{
+    free(sr_stacktrace_get_bthash(benchmark->stacktrace, SR_BTHASH_NORMAL));
+}
+
+static void
+run_distance(struct benchmark *benchmark)
+{
+    sr_distance(benchmark->distance, benchmark->threads[0],
+                benchmark->threads[1]);
+}
+
+static void
+run_threads_compare(struct benchmark *benchmark)
+{
+    sr_distances_free(sr_threads_compare(benchmark->threads,
+                                         benchmark->thread_count,
+                                         benchmark->thread_count,
+                                         benchmark->distance));
+}
+
+static void
+run_cluster_objects(struct benchmark *benchmark)
+{
+    sr_dendrogram_free(sr_distances_cluster_objects(benchmark->distances));
+}
+
+/* Normalizes a copy, as the normalization modifies the thread. */
+static void
+run_normalize(struct benchmark *benchmark)
+{
+    struct sr_gdb_thread *thread = sr_gdb_thread_dup(benchmark->gdb_thread,
+                                                     false);
+    sr_normalize_gdb_thread(thread);
+    sr_gdb_thread_free(thread);
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+measure(struct benchmark *benchmark)
+{
+    if (filter && !strstr(benchmark->name, filter))
+        return;
+
+    /* Warm up the caches, then double the iterations until the run is
+     * long enough to be measured reliably. */
+    benchmark->run(benchmark);
+
+    unsigned long iterations = 1;
+    double elapsed;
+    while (true)
+    {
+        double start = now();
+        for (unsigned long i = 0; i < iterations; ++i)
+            benchmark->run(benchmark);
+
+        elapsed = now() - start;
+        if (elapsed >= min_seconds)
+            break;
+
+        iterations *= 2;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    struct sr_strbuf *strbuf = sr_strbuf_new();
+    sr_strbuf_append_strf(strbuf,
+                          "{\"name\": \"%s\", \"iterations\": %lu, "
+                          "\"ns_per_op\": %.1f, \"ops_per_sec\": %.1f",
+                          benchmark->name, iterations,
+                          elapsed * 1e9 / iterations, iterations / elapsed);
+
+    if (benchmark->length > 0)
+    {
+        sr_strbuf_append_strf(strbuf, ", \"bytes_per_sec\": %.1f",
+                              benchmark->length * iterations / elapsed);
+    }
+
+    sr_strbuf_append_strf(strbuf, ", \"peak_rss_kb\": %ld}\n",
+                          usage.ru_maxrss);
+
+    fputs(strbuf->buf, stdout);
+    fflush(stdout);
+    sr_strbuf_free(strbuf);
+}
+
+/* Builds a gdb stacktrace of SCALED_THREADS threads with SCALED_FRAMES
+ * frames each.  The function names are taken from the fixture, shifted
+ * by the thread number, so the threads are similar but not equal. */
+static char *
+scaled_gdb_text(struct sr_stacktrace *fixture)
+{
+    size_t name_count = 0, allocated = 64;
+    const char **names = sr_malloc_array(allocated, sizeof(*names));
+    for (struct sr_thread *thread = sr_stacktrace_threads(fixture);
+         thread;
+         thread = sr_thread_next(thread))
+    {
+        for (struct sr_frame *frame = sr_thread_frames(thread);
+             frame;
+             frame = sr_frame_next(frame))
+        {
+            struct sr_gdb_frame *gdb_frame = (struct sr_gdb_frame *)frame;
+            if (!gdb_frame->function_name ||
+                0 == strcmp(gdb_frame->function_name, "??"))
+            {
+                continue;
+            }
+
+            if (name_count == allocated)
+            {
+                allocated *= 2;
+                names = sr_realloc_array(names, allocated, sizeof(*names));
+            }
+
+            names[name_count++] = gdb_frame->function_name;
+        }
+    }
+
+    if (name_count == 0)
+        fail("No function names in the gdb fixture");
+
+    struct sr_strbuf *strbuf = sr_strbuf_new();
+    for (int i = SCALED_THREADS; i > 0; --i)
+    {
+        sr_strbuf_append_strf(strbuf,
+                              "Thread %d (Thread 0x7f%08x (LWP %d)):\n",
+                              i, 0x1000 * i, 1000 + i);
+
+        for (int j = 0; j < SCALED_FRAMES; ++j)
+        {
+            sr_strbuf_append_strf(strbuf,
+                                  "#%d  0x%016llx in %s () from /usr/lib64/libsynthetic.so.%d\n",
+                                  j, 0x3000000000ULL + 16 * (i * SCALED_FRAMES + j),
+                                  names[(i / 4 + j) % name_count], j % 4);
+        }
+
+        sr_strbuf_append_char(strbuf, '\n');
+    }
+
+    free(names);
+    return sr_strbuf_free_nobuf(strbuf);
+}
+
+/* Builds a gdb thread of NORMALIZED_FRAMES frames by repeating the frames
+ * of all the threads of the fixture, so that the rules are looked up for
+ * real function and source file names. */
+static struct sr_gdb_thread *
+long_gdb_thread(struct sr_stacktrace *fixture)
+{
+    struct sr_gdb_thread *result = sr_gdb_thread_new();
+    struct sr_gdb_frame **tail = &result->frames;
+    int count = 0;
+    while (count < NORMALIZED_FRAMES)
+    {
+        int previous_count = count;
+        for (struct sr_thread *thread = sr_stacktrace_threads(fixture);
+             thread && count < NORMALIZED_FRAMES;
+             thread = sr_thread_next(thread))
+        {
+            for (struct sr_frame *frame = sr_thread_frames(thread);
+                 frame && count < NORMALIZED_FRAMES;
+                 frame = sr_frame_next(frame))
+            {
+                *tail = sr_gdb_frame_dup((struct sr_gdb_frame *)frame, false);
+                (*tail)->number = count++;
+                tail = &(*tail)->next;
+            }
+        }
+
+        if (count == previous_count)
+            fail("No frames in the gdb fixture");
+    }
+
+    return result;
+}
+
+static struct benchmark *
+benchmark_new(const char *name,
+              void (*run)(struct benchmark *benchmark))
+{
+    struct benchmark *benchmark = sr_mallocz(sizeof(*benchmark));
+    benchmark->name = sr_strdup(name);
+    benchmark->run = run;
+    return benchmark;
+}
+
+static void
+benchmark_free(struct benchmark *benchmark)
+{
+    free(benchmark->name);
+    free(benchmark);
+}
+
+static void
+bench_text(const char *name, enum sr_report_type type, char *text,
+           struct sr_stacktrace *stacktrace)
+{
+    char *full_name = sr_asprintf("parse/%s", name);
+    struct benchmark *benchmark = benchmark_new(full_name, run_parse);
+    benchmark->type = type;
+    benchmark->text = text;
+    benchmark->length = strlen(text);
+    measure(benchmark);
+    benchmark_free(benchmark);
+    free(full_name);
+
+    full_name = sr_asprintf("duphash/%s", name);
+    benchmark = benchmark_new(full_name, run_duphash);
+    benchmark->stacktrace = stacktrace;
+    measure(benchmark);
+    benchmark_free(benchmark);
+    free(full_name);
+
+    full_name = sr_asprintf("bthash/%s", name);
+    benchmark = benchmark_new(full_name, run_bthash);
+    benchmark->stacktrace = stacktrace;
+    measure(benchmark);
+    benchmark_free(benchmark);
+    free(full_name);
+}
+
+static void
+bench_distances(const char *name, struct sr_thread **threads,
+                int thread_count)
+{
+    for (int i = 0; i < SR_DISTANCE_NUM; ++i)
+    {
+        char *full_name = sr_asprintf("distance/%s/%s", distance_names[i],
+                                      name);
+        struct benchmark *benchmark = benchmark_new(full_name, run_distance);
+        benchmark->threads = threads;
+        benchmark->distance = i;
+        measure(benchmark);
+        benchmark_free(benchmark);
+        free(full_name);
+    }
+
+    char *full_name = sr_asprintf("threads_compare/%s/%d", name, thread_count);
+    struct benchmark *benchmark = benchmark_new(full_name,
+                                                run_threads_compare);
+    benchmark->threads = threads;
+    benchmark->thread_count = thread_count;
+    benchmark->distance = SR_DISTANCE_LEVENSHTEIN;
+    measure(benchmark);
+    benchmark_free(benchmark);
+    free(full_name);
+
+    full_name = sr_asprintf("cluster_objects/%s/%d", name, thread_count);
+    benchmark = benchmark_new(full_name, run_cluster_objects);
+    benchmark->distances = sr_threads_compare(threads, thread_count,
+                                              thread_count,
+                                              SR_DISTANCE_LEVENSHTEIN);
+    measure(benchmark);
+    sr_distances_free(benchmark->distances);
+    benchmark_free(benchmark);
+    free(full_name);
+}
+
+/* Clusters the corpus at this level of the dendrogram. */
+#define CORPUS_LEVEL 0.3
+
+static double
+pairs(unsigned long count)
+{
+    return count * (count - 1.0) / 2;
+}
+
+static void
+bench_corpus(const char *directory, unsigned long thread_count)
+{
+    struct corpus_options options = {
+        .threads = thread_count,
+        .frames = 30,
+        .clusters = thread_count < 10 ? 1 : thread_count / 10,
+        .mutation = 0.1,
+        .skew = 1.0,
+        .seed = 1,
+    };
+
+    char *error_message = NULL;
+    char *path = sr_build_path(directory, "gdb_stacktraces", NULL);
+    struct corpus *corpus = corpus_new(path, &options, &error_message);
+    free(path);
+    if (!corpus)
+        fail(error_message);
+
+    struct sr_stacktrace **stacktraces =
+        sr_malloc_array(thread_count, sizeof(*stacktraces));
+    struct sr_thread **threads = sr_malloc_array(thread_count,
+                                                 sizeof(*threads));
+    unsigned long *labels = sr_malloc_array(thread_count, sizeof(*labels));
+    struct sr_strbuf *strbuf = sr_strbuf_new();
+    for (unsigned long i = 0; i < thread_count; ++i)
+    {
+        labels[i] = corpus_append_thread(corpus, i, strbuf);
+        stacktraces[i] = parse(SR_REPORT_GDB, strbuf->buf);
+        threads[i] = sr_stacktrace_threads(stacktraces[i]);
+        sr_strbuf_clear(strbuf);
+    }
+
+    sr_strbuf_free(strbuf);
+
+    double start = now();
+    struct sr_distances *distances =
+        sr_threads_compare(threads, thread_count, thread_count,
+                           SR_DISTANCE_LEVENSHTEIN);
+    struct sr_dendrogram *dendrogram = sr_distances_cluster_objects(distances);
+    struct sr_cluster *clusters = sr_dendrogram_cut(dendrogram, CORPUS_LEVEL, 1);
+    double elapsed = now() - start;
+
+    /* Pairs of threads in the same cluster found, in the same cluster of
+     * the corpus, and in both. */
+    double found = 0, expected = 0, correct = 0;
+    unsigned long *counts = sr_mallocz(options.clusters * sizeof(*counts));
+    while (clusters)
+    {
+        found += pairs(clusters->size);
+        for (int i = 0; i < clusters->size; ++i)
+            ++counts[labels[clusters->objects[i]]];
+
+        for (int i = 0; i < clusters->size; ++i)
+        {
+            correct += pairs(counts[labels[clusters->objects[i]]]);
+            counts[labels[clusters->objects[i]]] = 0;
+        }
+
+        struct sr_cluster *next = clusters->next;
+        sr_cluster_free(clusters);
+        clusters = next;
+    }
+
+    for (unsigned long k = 0; k < options.clusters; ++k)
+        expected += pairs(corpus_cluster_size(corpus, k));
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("{\"name\": \"cluster_corpus/%lu\", \"iterations\": 1, "
+           "\"ns_per_op\": %.1f, \"ops_per_sec\": %.1f, "
+           "\"threads_per_sec\": %.1f, \"pair_precision\": %.4f, "
+           "\"pair_recall\": %.4f, \"peak_rss_kb\": %ld}\n",
+           thread_count, elapsed * 1e9, 1 / elapsed, thread_count / elapsed,
+           found > 0 ? correct / found : 1.0,
+           expected > 0 ? correct / expected : 1.0,
+           usage.ru_maxrss);
+    fflush(stdout);
+
+    free(counts);
+    sr_dendrogram_free(dendrogram);
+    sr_distances_free(distances);
+    for (unsigned long i = 0; i < thread_count; ++i)
+        sr_stacktrace_free(stacktraces[i]);
+
+    free(stacktraces);
+    free(threads);
+    free(labels);
+    corpus_free(corpus);
+}
+
+static void
+usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-t SECONDS] [-f FILTER] [-n THREADS] "
+                    "[FIXTURES_DIR]\n", program);
+    exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *directory = ".";
+    unsigned long corpus_threads = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "-t") && i + 1 < argc)
+        {
+            char *end;
+            min_seconds = strtod(argv[++i], &end);
+            if (*end != '\0' || min_seconds <= 0)
+                usage(argv[0]);
+        }
+        else if (0 == strcmp(argv[i], "-f") && i + 1 < argc)
+            filter = argv[++i];
+        else if (0 == strcmp(argv[i], "-n") && i + 1 < argc)
+        {
+            char *end;
+            corpus_threads = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || corpus_threads < 2)
+                usage(argv[0]);
+        }
+        else if (argv[i][0] == '-')
+            usage(argv[0]);
+        else
+            directory = argv[i];
+    }
+
+    struct sr_stacktrace *gdb_fixture = NULL;
+    for (size_t i = 0; i < sizeof(fixtures) / sizeof(*fixtures); ++i)
+    {
+        char *error_message = NULL;
+        char *path = sr_build_path(directory, fixtures[i][1], NULL);
+        char *text = sr_file_to_string(path, &error_message);
+        free(path);
+        if (!text)
+            fail(error_message);
+
+        enum sr_report_type type = sr_report_type_from_string(fixtures[i][0]);
+        struct sr_stacktrace *stacktrace = parse(type, text);
+        bench_text(fixtures[i][0], type, text, stacktrace);
+        free(text);
+
+        if (type == SR_REPORT_GDB)
+            gdb_fixture = stacktrace;
+        else
+            sr_stacktrace_free(stacktrace);
+    }
+
+    char *error_message = NULL;
+    char *path = sr_build_path(directory, "json_files/ureport-1", NULL);
+    char *text = sr_file_to_string(path, &error_message);
+    free(path);
+    if (!text)
+        fail(error_message);
+
+    struct sr_report *report = sr_report_from_json_text(text, &error_message);
+    free(text);
+    if (!report)
+        fail(error_message);
+
+    struct benchmark *benchmark = benchmark_new("bthash/ureport", run_bthash);
+    benchmark->stacktrace = report->stacktrace;
+    measure(benchmark);
+    benchmark_free(benchmark);
+    sr_report_free(report);
+
+    /* The scaled-up gdb stacktrace is benchmarked like the fixtures, and
+     * its threads are compared and clustered. */
+    text = scaled_gdb_text(gdb_fixture);
+    struct sr_stacktrace *scaled = parse(SR_REPORT_GDB, text);
+    bench_text("gdb_scaled", SR_REPORT_GDB, text, scaled);
+    free(text);
+
+    struct sr_thread *threads[SCALED_THREADS];
+    int thread_count = 0;
+    for (struct sr_thread *thread = sr_stacktrace_threads(scaled);
+         thread && thread_count < SCALED_THREADS;
+         thread = sr_thread_next(thread))
+    {
+        threads[thread_count++] = thread;
+    }
+
+    bench_distances("gdb_scaled", threads, thread_count);
+    sr_stacktrace_free(scaled);
+
+    char *normalize_name = sr_asprintf("normalize/gdb_%d", NORMALIZED_FRAMES);
+    benchmark = benchmark_new(normalize_name, run_normalize);
+    benchmark->gdb_thread = long_gdb_thread(gdb_fixture);
+    measure(benchmark);
+    sr_gdb_thread_free(benchmark->gdb_thread);
+    benchmark_free(benchmark);
+    free(normalize_name);
+    sr_stacktrace_free(gdb_fixture);
+
+    if (corpus_threads > 0 &&
+        (!filter || strstr("cluster_corpus", filter)))
+    {
+        bench_corpus(directory, corpus_threads);
+    }
+    return 0;
+}
@@ -0,0 +1,359 @@
+/*
+    corpus.c
+
+    Copyright (C) 2013  Red Hat, Inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "corpus.h"
+#include "frame.h"
+#include "gdb/frame.h"
+#include "hash_table.h"
+#include "stacktrace.h"
+#include "strbuf.h"
+#include "thread.h"
+#include "utils.h"
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct corpus_frame
+{
+    char *function_name;
+    /* " at FILE:LINE", " from LIBRARY" or an empty string. */
+    char *location;
+};
+
+struct corpus
+{
+    struct corpus_options options;
+    struct corpus_frame *vocabulary;
+    size_t vocabulary_size;
+    /* options.frames indices to the vocabulary for every cluster. */
+    size_t *prototypes;
+    /* The cluster of every thread. */
+    unsigned long *labels;
+    unsigned long *sizes;
+};
+
+/* SplitMix64, so that a seed gives the same corpus everywhere. */
+static uint64_t
+next_random(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static size_t
+random_below(uint64_t *state, size_t limit)
+{
+    return next_random(state) % limit;
+}
+
+static double
+random_unit(uint64_t *state)
+{
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void
+add_frames(struct corpus *corpus, struct hash_table *seen,
+           size_t *allocated, struct sr_stacktrace *stacktrace)
+{
+    for (struct sr_thread *thread = sr_stacktrace_threads(stacktrace);
+         thread;
+         thread = sr_thread_next(thread))
+    {
+        for (struct sr_frame *frame = sr_thread_frames(thread);
+             frame;
+             frame = sr_frame_next(frame))
+        {
+            struct sr_gdb_frame *gdb_frame = (struct sr_gdb_frame *)frame;
+            const char *name = gdb_frame->function_name;
+            if (!name || 0 == strcmp(name, "??") ||
+                hash_table_lookup(seen, name, NULL))
+            {
+                continue;
+            }
+
+            hash_table_insert(seen, sr_strdup(name), NULL);
+            if (corpus->vocabulary_size == *allocated)
+            {
+                *allocated *= 2;
+                corpus->vocabulary =
+                    sr_realloc_array(corpus->vocabulary, *allocated,
+                                     sizeof(*corpus->vocabulary));
+            }
+
+            struct corpus_frame *entry =
+                &corpus->vocabulary[corpus->vocabulary_size++];
+
+            entry->function_name = sr_strdup(name);
+            if (gdb_frame->source_file)
+            {
+                entry->location = sr_asprintf(" at %s:%"PRIu32,
+                                              gdb_frame->source_file,
+                                              gdb_frame->source_line);
+            }
+            else if (gdb_frame->library_name)
+            {
+                entry->location = sr_asprintf(" from %s",
+                                              gdb_frame->library_name);
+            }
+            else
+                entry->location = sr_strdup("");
+        }
+    }
+}
+
+static bool
+load_vocabulary(struct corpus *corpus, const char *directory,
+                char **error_message)
+{
+    /* Sorted, so that the corpus does not depend on the directory order. */
+    struct dirent **entries;
+    int count = scandir(directory, &entries, NULL, alphasort);
+    if (count < 0)
+    {
+        *error_message = sr_asprintf("Unable to read '%s': %s", directory,
+                                     strerror(errno));
+        return false;
+    }
+
+    struct hash_table *seen = hash_table_new(hash_string,
+                                             string_equal,
+                                             free, NULL);
+    size_t allocated = 256;
+    corpus->vocabulary = sr_malloc_array(allocated,
+                                         sizeof(*corpus->vocabulary));
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (entries[i]->d_name[0] != '.')
+        {
+            char *path = sr_build_path(directory, entries[i]->d_name, NULL);
+            char *text = sr_file_to_string(path, error_message);
+            free(path);
+            if (!text)
+            {
+                free(*error_message);
+                *error_message = NULL;
+            }
+            else
+            {
+                /* Fixtures the parser refuses are skipped. */
+                char *parse_error = NULL;
+                struct sr_stacktrace *stacktrace =
+                    sr_stacktrace_parse(SR_REPORT_GDB, text, &parse_error);
+
+                if (stacktrace)
+                {
+                    add_frames(corpus, seen, &allocated, stacktrace);
+                    sr_stacktrace_free(stacktrace);
+                }
+
+                free(parse_error);
+                free(text);
+            }
+        }
+
+        free(entries[i]);
+    }
+
+    free(entries);
+    hash_table_free(seen);
+
+    if (corpus->vocabulary_size == 0)
+    {
+        *error_message = sr_asprintf("No gdb frames found in '%s'",
+                                     directory);
+        return false;
+    }
+
+    return true;
+}
+
+/* Every cluster gets a thread, the rest is split in proportion to the
+ * weights 1/k^skew. */
+static void
+assign_sizes(struct corpus *corpus)
+{
+    const struct corpus_options *options = &corpus->options;
+    double *weights = sr_malloc_array(options->clusters, sizeof(*weights));
+    double sum = 0;
+    for (unsigned long k = 0; k < options->clusters; ++k)
+    {
+        weights[k] = pow(k + 1, -options->skew);
+        sum += weights[k];
+    }
+
+    unsigned long rest = options->threads - options->clusters;
+    unsigned long assigned = 0;
+    corpus->sizes = sr_malloc_array(options->clusters, sizeof(*corpus->sizes));
+    for (unsigned long k = 0; k < options->clusters; ++k)
+    {
+        corpus->sizes[k] = 1 + (unsigned long)(rest * weights[k] / sum);
+        assigned += corpus->sizes[k];
+    }
+
+    /* The rounding leftover goes to the largest clusters. */
+    for (unsigned long k = 0; assigned < options->threads; ++k, ++assigned)
+        ++corpus->sizes[k % options->clusters];
+
+    free(weights);
+}
+
+struct corpus *
+corpus_new(const char *gdb_stacktraces_dir,
+           const struct corpus_options *options,
+           char **error_message)
+{
+    if (options->threads == 0 || options->frames == 0 ||
+        options->clusters == 0 || options->clusters > options->threads)
+    {
+        *error_message = sr_strdup("The corpus needs at least one thread "
+                                   "and frame, and at most as many clusters "
+                                   "as threads");
+        return NULL;
+    }
+
+    struct corpus *corpus = sr_mallocz(sizeof(*corpus));
+    corpus->options = *options;
+    if (!load_vocabulary(corpus, gdb_stacktraces_dir, error_message))
+    {
+        corpus_free(corpus);
+        return NULL;
+    }
+
+    uint64_t state = options->seed;
+    corpus->prototypes = sr_malloc_array(options->clusters * options->frames,
+                                         sizeof(*corpus->prototypes));
+    for (size_t i = 0; i < options->clusters * options->frames; ++i)
+        corpus->prototypes[i] = random_below(&state, corpus->vocabulary_size);
+
+    assign_sizes(corpus);
+
+    corpus->labels = sr_malloc_array(options->threads,
+                                     sizeof(*corpus->labels));
+    unsigned long index = 0;
+    for (unsigned long k = 0; k < options->clusters; ++k)
+    {
+        for (unsigned long i = 0; i < corpus->sizes[k]; ++i)
+            corpus->labels[index++] = k;
+    }
+
+    /* Fisher-Yates shuffle, so that the clusters are interleaved. */
+    for (unsigned long i = options->threads - 1; i > 0; --i)
+    {
+        unsigned long j = random_below(&state, i + 1);
+        unsigned long label = corpus->labels[i];
+        corpus->labels[i] = corpus->labels[j];
+        corpus->labels[j] = label;
+    }
+
+    return corpus;
+}
+
+void
+corpus_free(struct corpus *corpus)
+{
+    if (!corpus)
+        return;
+
+    for (size_t i = 0; i < corpus->vocabulary_size; ++i)
+    {
+        free(corpus->vocabulary[i].function_name);
+        free(corpus->vocabulary[i].location);
+    }
+
+    free(corpus->vocabulary);
+    free(corpus->prototypes);
+    free(corpus->labels);
+    free(corpus->sizes);
+    free(corpus);
+}
+
+static void
+append_frame(struct corpus *corpus, uint64_t *state, unsigned *number,
+             size_t vocabulary_index, struct sr_strbuf *strbuf)
+{
+    const struct corpus_frame *frame = &corpus->vocabulary[vocabulary_index];
+    sr_strbuf_append_strf(strbuf, "#%u  0x%016llx in %s ()%s\n",
+                          (*number)++,
+                          0x3000000000ULL + (next_random(state) & 0xfffffff0),
+                          frame->function_name, frame->location);
+}
+
+unsigned long
+corpus_append_thread(struct corpus *corpus,
+                     unsigned long index,
+                     struct sr_strbuf *strbuf)
+{
+    /* Every thread has its own random sequence, so the threads can be
+     * generated in any order. */
+    uint64_t state = corpus->options.seed ^ (index * 0xff51afd7ed558ccdULL);
+    next_random(&state);
+
+    unsigned long cluster = corpus->labels[index];
+    const size_t *prototype =
+        &corpus->prototypes[cluster * corpus->options.frames];
+
+    sr_strbuf_append_strf(strbuf, "Thread %lu (Thread 0x7f%010llx (LWP %lu)):\n",
+                          index + 1,
+                          (unsigned long long)(next_random(&state) & 0xfffffff000ULL),
+                          1000 + index);
+
+    unsigned number = 0;
+    for (unsigned i = 0; i < corpus->options.frames; ++i)
+    {
+        if (random_unit(&state) >= corpus->options.mutation)
+        {
+            append_frame(corpus, &state, &number, prototype[i], strbuf);
+            continue;
+        }
+
+        size_t other = random_below(&state, corpus->vocabulary_size);
+        switch (random_below(&state, 3))
+        {
+        case 0: /* Replaced. */
+            append_frame(corpus, &state, &number, other, strbuf);
+            break;
+        case 1: /* Removed. */
+            break;
+        default: /* Added. */
+            append_frame(corpus, &state, &number, other, strbuf);
+            append_frame(corpus, &state, &number, prototype[i], strbuf);
+            break;
+        }
+    }
+
+    /* A thread with all the frames removed still needs one. */
+    if (number == 0)
+        append_frame(corpus, &state, &number, prototype[0], strbuf);
+
+    sr_strbuf_append_char(strbuf, '\n');
+    return cluster;
+}
+
+unsigned long
+corpus_cluster_size(struct corpus *corpus, unsigned long cluster)
+{
+    return corpus->sizes[cluster];
+}
@@ -0,0 +1,80 @@
+/*
+    corpus.h
+
+    Copyright (C) 2013  Red Hat, Inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef SATYR_CORPUS_H
+#define SATYR_CORPUS_H
+
+/* Generator of large synthetic corpora of gdb threads for the benchmarks.
+ *
+ * The frames are taken from the gdb stacktraces among the test fixtures.
+ * Every cluster of the corpus has a prototype thread made of random
+ * frames, and the threads of the cluster are copies of the prototype with
+ * some frames replaced, removed or added.  The threads of all clusters
+ * are shuffled, and the cluster of every thread is known, so the result
+ * of a clustering can be compared with it.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct sr_strbuf;
+
+struct corpus_options
+{
+    /* Number of threads in the corpus. */
+    unsigned long threads;
+    /* Number of frames of the prototype threads. */
+    unsigned frames;
+    /* Number of clusters, at most the number of threads. */
+    unsigned long clusters;
+    /* Probability that a frame of a thread differs from the prototype. */
+    double mutation;
+    /* The size of the k-th cluster is proportional to 1/k^skew, so 0
+     * gives clusters of equal sizes. */
+    double skew;
+    uint64_t seed;
+};
+
+struct corpus;
+
+/* Reads the frames of all the gdb stacktraces in the directory and
+ * prepares the clusters of the corpus.  Returns NULL and sets
+ * *error_message on failure. */
+struct corpus *
+corpus_new(const char *gdb_stacktraces_dir,
+           const struct corpus_options *options,
+           char **error_message);
+
+void
+corpus_free(struct corpus *corpus);
+
+/* Appends the index-th thread of the corpus to the buffer in the format of
+ * gdb, and returns the cluster of the thread.  The threads do not depend
+ * on each other, so they can be generated in any order. */
+unsigned long
+corpus_append_thread(struct corpus *corpus,
+                     unsigned long index,
+                     struct sr_strbuf *strbuf);
+
+/* Returns the number of threads in the cluster. */
+unsigned long
+corpus_cluster_size(struct corpus *corpus, unsigned long cluster);
+
+#endif
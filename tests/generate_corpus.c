@@ -0,0 +1,150 @@
+/*
+    generate_corpus.c
+
+    Copyright (C) 2013  Red Hat, Inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/* Writes a synthetic corpus of gdb threads, see corpus.h, to standard
+ * output.  By default every thread is a separate stacktrace and the
+ * stacktraces are separated by NUL bytes, which is the payload of the
+ * cluster request of `satyr serve'.  With -1 all the threads form a
+ * single stacktrace.  The cluster of every thread is written on a line
+ * of the labels file.
+ */
+#include "corpus.h"
+#include "strbuf.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void
+usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-n THREADS] [-f FRAMES] [-c CLUSTERS] "
+                    "[-m MUTATION] [-z SKEW] [-s SEED] [-1] [-l LABELS] "
+                    "[GDB_STACKTRACES_DIR]\n", program);
+    exit(1);
+}
+
+static double
+number_argument(const char *program, const char *text)
+{
+    char *end;
+    double value = strtod(text, &end);
+    if (*end != '\0' || value < 0)
+        usage(program);
+
+    return value;
+}
+
+int
+main(int argc, char **argv)
+{
+    struct corpus_options options = {
+        .threads = 1000,
+        .frames = 30,
+        .clusters = 100,
+        .mutation = 0.1,
+        .skew = 1.0,
+        .seed = 1,
+    };
+
+    const char *directory = "gdb_stacktraces";
+    const char *labels_path = NULL;
+    bool single = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *option = argv[i];
+        if (0 == strcmp(option, "-1"))
+            single = true;
+        else if (option[0] == '-' && option[1] != '\0' && option[2] == '\0' &&
+                 i + 1 < argc)
+        {
+            const char *value = argv[++i];
+            switch (option[1])
+            {
+            case 'n':
+                options.threads = number_argument(argv[0], value);
+                break;
+            case 'f':
+                options.frames = number_argument(argv[0], value);
+                break;
+            case 'c':
+                options.clusters = number_argument(argv[0], value);
+                break;
+            case 'm':
+                options.mutation = number_argument(argv[0], value);
+                break;
+            case 'z':
+                options.skew = number_argument(argv[0], value);
+                break;
+            case 's':
+                options.seed = number_argument(argv[0], value);
+                break;
+            case 'l':
+                labels_path = value;
+                break;
+            default:
+                usage(argv[0]);
+            }
+        }
+        else if (option[0] == '-')
+            usage(argv[0]);
+        else
+            directory = option;
+    }
+
+    char *error_message = NULL;
+    struct corpus *corpus = corpus_new(directory, &options, &error_message);
+    if (!corpus)
+    {
+        fprintf(stderr, "%s\n", error_message);
+        free(error_message);
+        return 1;
+    }
+
+    FILE *labels = NULL;
+    if (labels_path)
+    {
+        labels = fopen(labels_path, "w");
+        if (!labels)
+        {
+            perror(labels_path);
+            return 1;
+        }
+    }
+
+    struct sr_strbuf *strbuf = sr_strbuf_new();
+    for (unsigned long i = 0; i < options.threads; ++i)
+    {
+        unsigned long cluster = corpus_append_thread(corpus, i, strbuf);
+        if (labels)
+            fprintf(labels, "%lu\n", cluster);
+
+        /* The NUL byte of the buffer separates the stacktraces. */
+        fwrite(strbuf->buf, 1, strbuf->len + !single, stdout);
+        sr_strbuf_clear(strbuf);
+    }
+
+    sr_strbuf_free(strbuf);
+    corpus_free(corpus);
+    if (labels)
+        fclose(labels);
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#define WAITING_THREADS 3
+
+static pthread_barrier_t barrier;
+
+static void *
+wait_forever(void *arg)
+{
+    pthread_barrier_wait(&barrier);
+    while (1)
+        pause();
+
+    return 0;
+}
+
+static void *
+crash(void *arg)
+{
+    pthread_barrier_wait(&barrier);
+    /* Let the other threads block in pause() first. */
+    usleep(100000);
+    int *p = 0;
+    *p = 10;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    /* Small stacks keep the core dump small. */
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 65536);
+
+    pthread_t thread;
+    pthread_barrier_init(&barrier, NULL, WAITING_THREADS + 2);
+    for (int i = 0; i < WAITING_THREADS; ++i)
+        pthread_create(&thread, &attr, wait_forever, NULL);
+
+    pthread_create(&thread, &attr, crash, NULL);
+    pthread_barrier_wait(&barrier);
+    while (1)
+        pause();
+
+    return 0;
+}
@@ -11,6 +11,12 @@ class TestMisc(BindingsTestCase):
         self.assertEqual(satyr.demangle_symbol('_ZN9wikipedia7article6formatEv'),
                          'wikipedia::article::format()')
 
+    def test_demangle_symbols(self):
+        self.assertEqual(satyr.demangle_symbols(['f', '_ZN9wikipedia7article6formatEv',
+                                                 '_ZN9wikipedia7article6formatEv']),
+                         ['f', 'wikipedia::article::format()',
+                          'wikipedia::article::format()'])
+
 
 if __name__ == '__main__':
     unittest.main()